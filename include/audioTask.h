@@ -0,0 +1,27 @@
+#pragma once
+#include <Arduino.h>
+
+class Audio;
+
+/**
+ * The task which runs the audio loop of both zones on core 1. Menu 
+ * actions call into the audio objects while holding audioLock(), other 
+ * tasks read the status the audio task publishes after each refill.
+ */
+#define NBR_ZONES  2
+
+extern Audio audio;   // zone 1
+
+void audioLock();
+void audioUnlock();
+void pauseAudioTask(bool pause);
+void wakeAudioTask();
+void startAudioTask();
+Audio &zoneAudio(uint8_t zone);
+uint8_t currentZone();
+bool zoneCanPlay(uint8_t zone, const char *source);
+
+bool audioRunning();
+uint8_t audioFillPercent();
+uint32_t audioBitRate();
+uint32_t audioBufferBytes();
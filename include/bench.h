@@ -0,0 +1,28 @@
+#pragma once
+#include <Arduino.h>
+
+/**
+ * Report of the benchmarks, shared by the board benchmark and the host
+ * benchmark in test/bench. Each result is compared with its baseline,
+ * a result worse than the baseline by more than the tolerance counts
+ * as a regression. benchEnd() prints the verdict as the last line.
+ */
+struct BenchBaseline
+{
+  const char *name;
+  uint32_t value;
+  uint8_t tolerancePercent;
+  bool higherIsBetter;
+};
+
+void benchBegin(const BenchBaseline *baselines, size_t count, bool csv);
+void benchReport(const char *name, uint32_t value, const char *unit);
+uint8_t benchEnd();
+bool benchCsv();
+
+/**
+ * Inputs which drive the parsers into their slowest paths, 
+ * generated into buf. Return false after the last one.
+ */
+bool worstCaseMp3(uint8_t i, uint8_t *buf, size_t len);
+bool worstCaseText(uint8_t i, uint8_t *buf, size_t len);
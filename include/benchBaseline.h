@@ -0,0 +1,40 @@
+#pragma once
+#include "bench.h"
+
+/**
+ * Results of the benchmarks on the reference board, an ESP32-D0WD at
+ * 240 MHz with the fixture on LittleFS. A result worse than its baseline
+ * by more than the tolerance is reported as a regression. To record the
+ * baselines, run the CSV benchmark on the reference board and copy the
+ * values; a value of 0 has not been recorded yet and is not judged.
+ * The kernels which also run on the host are gated in test/bench.
+ */
+static const BenchBaseline benchBaselines[] =
+{
+  { "flash read",                0, 15, true  },
+  { "spiffs read",               0, 15, true  },
+  { "littlefs read",             0, 15, true  },
+  { "littlefs read-ahead read",  0, 15, true  },
+  { "dram copy",                 0, 10, true  },
+  { "psram copy",                0, 10, true  },
+  { "dram to psram copy",        0, 10, true  },
+  { "dsp gap conceal",           0, 10, false },
+  { "dsp volume",                0, 10, false },
+  { "dsp volume + dither",       0, 10, false },
+  { "dsp level meter",           0, 10, false },
+  { "parse mp3 sync worst case", 0, 20, false },
+  { "parse charset worst case",  0, 20, false },
+  { "parse playlist worst case", 0, 20, false },
+  { "parse stream title",        0, 20, false },
+  { "menu dispatch lookup",      0, 20, false },
+  { "mp3 decode + i2s write",    0, 10, false },
+  { "mp3 play per frame",        0, 10, false },
+  { "mp3 play speed",            0, 10, true  },
+  { "mp3 play stereo",           0, 10, false },
+  { "mp3 play forced mono",      0, 10, false },
+  { "forced mono saving",        0, 50, true  },
+  { "play at 240 MHz",           0, 10, false },
+  { "play at 160 MHz",           0, 10, false },
+  { "supply at 240 MHz",         0, 10, false },
+  { "supply at 160 MHz",         0, 10, false },
+};
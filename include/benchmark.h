@@ -0,0 +1,7 @@
+#pragma once
+
+/**
+ * Benchmarks and self tests on the board
+ */
+void runBenchmarks(bool csv);
+void resyncSelfTest(const char *txt);
@@ -0,0 +1,8 @@
+#pragma once
+#include <Arduino.h>
+
+/**
+ * Stream titles in ISO-8859-1 or Windows-1252 converted to UTF-8
+ */
+size_t toUtf8(char *buf, size_t size);
+const char *metadataToUtf8(const char *info);
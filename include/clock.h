@@ -0,0 +1,28 @@
+#pragma once
+#include <Arduino.h>
+
+/**
+ * Time base for timeouts, schedules and time stamps. The host tests 
+ * build with -DVIRTUAL_CLOCK, there the time only moves when the test 
+ * calls clockAdvance() or the code sleeps with clockSleep(), so hours 
+ * of schedules run in milliseconds and always the same way.
+ * CPU time measurements keep using micros().
+ */
+#ifdef VIRTUAL_CLOCK
+
+#ifdef ARDUINO
+#error "VIRTUAL_CLOCK is for the host tests, FreeRTOS timeouts on the board keep the real time"
+#endif
+
+uint32_t clockMs();
+time_t clockTime();
+void clockAdvance(uint32_t ms);
+void clockSleep(uint32_t ms);
+
+#else
+
+inline uint32_t clockMs()           { return millis(); }
+inline time_t clockTime()           { return time(nullptr); }
+inline void clockSleep(uint32_t ms) { delay(ms); }
+
+#endif
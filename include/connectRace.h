@@ -0,0 +1,7 @@
+#pragma once
+#include <WiFi.h>
+
+/**
+ * Connects to all addresses of a host at once, the first one to answer wins
+ */
+int raceConnect(const char *host, uint16_t port, IPAddress &winner);
@@ -0,0 +1,64 @@
+#pragma once
+#include <Arduino.h>
+
+#define DISPLAY_WIDTH   128
+#define DISPLAY_PAGES   8     // rows of 8 pixels, one byte per column
+
+/**
+ * A display which receives partial updates of the framebuffer. The
+ * framebuffer is laid out like the SSD1306 RAM, each byte holds a
+ * column of 8 pixels, so a dirty region is a column range of a page.
+ */
+class DisplayBackend
+{
+  public:
+    virtual ~DisplayBackend() {}
+    virtual bool begin() = 0;
+    virtual void write(uint8_t page, uint8_t col0, uint8_t col1, const uint8_t *data) = 0;
+};
+
+
+/**
+ * SSD1306 128x64 on I2C. Only the dirty column range of a page is
+ * addressed and transferred.
+ */
+class Ssd1306Display : public DisplayBackend
+{
+  public:
+    Ssd1306Display(uint8_t sda, uint8_t scl, uint8_t address = 0x3C) : sda(sda), scl(scl), address(address) {}
+    bool begin() override;
+    void write(uint8_t page, uint8_t col0, uint8_t col1, const uint8_t *data) override;
+
+  private:
+    void command(const uint8_t *cmds, size_t len);
+    uint8_t sda, scl, address;
+};
+
+
+/**
+ * Display without hardware, which keeps a copy of the pixels and
+ * counts the transferred bytes. Its content is printed as text.
+ */
+class VirtualDisplay : public DisplayBackend
+{
+  public:
+    bool begin() override { return true; }
+    void write(uint8_t page, uint8_t col0, uint8_t col1, const uint8_t *data) override;
+    void print(Print &out);
+    uint32_t bytes = 0;
+    uint32_t writes = 0;
+
+  private:
+    uint8_t ram[DISPLAY_PAGES][DISPLAY_WIDTH] = {};
+};
+
+
+/**
+ * The page shown on the display, redrawn by its task
+ */
+void initDisplay();
+uint32_t displayFrame();
+void displayStation(const char *txt);
+void displayTitle(const char *txt);
+void displayVolume(uint8_t zone, int vol);
+void showDisplay(const char *txt);
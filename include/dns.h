@@ -0,0 +1,11 @@
+#pragma once
+#include <Arduino.h>
+
+/**
+ * Just enough of DNS to ask for the A records of a host, which lwIP 
+ * does not return all of. Both work on a message buffer of the caller.
+ */
+#define DNS_MSG_SIZE 512   // largest message over UDP
+
+size_t dnsBuildQuery(const char *host, uint16_t id, uint8_t *msg, size_t size);
+int dnsParseAnswer(const uint8_t *msg, size_t len, uint16_t id, uint32_t *addrs, uint8_t max);
@@ -0,0 +1,13 @@
+#pragma once
+#include <Arduino.h>
+
+/**
+ * The DSP stage in audio_process_i2s(): gap concealment after a resync, 
+ * volume with dither and the peak levels of zone 1
+ */
+void dspOnInfo(const char *info);
+void setDigitalVolume(uint8_t zone, uint8_t vol, uint8_t maxVol);
+void setDither(bool on);
+bool ditherEnabled();
+void dspPeaks(uint16_t &left, uint16_t &right);
+void benchmarkDsp(void (*report)(const char *name, uint32_t value, const char *unit));
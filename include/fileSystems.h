@@ -0,0 +1,13 @@
+#pragma once
+#include <Arduino.h>
+#include "readAheadFS.h"
+
+/**
+ * SPIFFS and LittleFS, each behind a read-ahead layer
+ */
+extern ReadAheadFS spiffsRA;
+extern ReadAheadFS littlefsRA;
+
+void initFileSystems();
+uint32_t readThroughput(fs::FS &fs, const char *path);
+void benchmarkFileSystems(const char *txt);
@@ -0,0 +1,4 @@
+#pragma once
+#include <Arduino.h>
+
+void heartbeat(uint8_t pin, uint8_t nBeats, uint8_t t, uint8_t duty);
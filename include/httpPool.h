@@ -0,0 +1,18 @@
+#pragma once
+#include <WiFi.h>
+
+/**
+ * A small pool of keep-alive HTTP/1.1 connections keyed by host, port and
+ * scheme. Short requests (TTS, playlists, probes) acquire a client, run 
+ * their request with HTTPClient::setReuse(true) and release the client 
+ * again. A released client stays connected for HTTP_POOL_IDLE_MS, so the 
+ * next request to the same host skips the TCP and TLS handshake.
+ */
+#define HTTP_POOL_SOCKETS  3       // cap of concurrently open sockets
+#define HTTP_POOL_IDLE_MS  20000   // close connections idle for longer
+
+WiFiClient *httpPoolAcquire(const char *host, uint16_t port, bool tls);
+void httpPoolRelease(WiFiClient *client, bool keepAlive);
+void httpPoolMaintain();
+bool splitUrl(const char *url, bool &tls, char *host, size_t hostSize, uint16_t &port, const char *&path);
+int httpFetch(const char *url, char *body, size_t size);
@@ -0,0 +1,6 @@
+#pragma once
+#include <Arduino.h>
+
+bool initWiFi(const char ssid[], const char password[], const char hostname[]);
+void printNearbyNetworks();
+void printConnectionDetails();
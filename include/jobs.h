@@ -0,0 +1,6 @@
+#pragma once
+
+/**
+ * Registers the periodic jobs with the scheduler and starts it
+ */
+void startJobs();
@@ -0,0 +1,27 @@
+#pragma once
+#include <Arduino.h>
+
+class Audio;
+
+/**
+ * Placement of the buffers in the audio path. Bulk buffers, which are
+ * large, accessed in sequence and tolerate latency, go to PSRAM if the
+ * board has it. Decoder state, DMA and small buffers stay in internal
+ * RAM. To add a buffer, append a line with its id, label, default size
+ * and whether it is bulk.
+ */
+#define MEM_BUFFERS(X) \
+  X(MEM_STREAM,      "stream buffer",    0,    true) \
+  X(MEM_READ_AHEAD,  "read-ahead chunk", 4096, true) \
+  X(MEM_RECORDER,    "recorder block",   4096, true) \
+  X(MEM_MIRROR_FRAMES, "mirror frames",  16384, true) \
+  X(MEM_WEB_JSON,    "web json",         4096, true)
+
+#define MEM_BUFFER_ID(id, label, size, bulk) id,
+enum MemBuffer : uint8_t { MEM_BUFFERS(MEM_BUFFER_ID) MEM_BUFFER_COUNT };
+#undef MEM_BUFFER_ID
+
+void initMemPolicy();
+void *memAlloc(MemBuffer buf, size_t size);
+void placeStreamBuffer(Audio &audio);
+void showMemLayout(const char *txt);
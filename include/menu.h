@@ -0,0 +1,19 @@
+#pragma once
+#include <Arduino.h>
+
+/**
+ * The menu of main.cpp and the state the keys act on, shared with 
+ * the web UI and the benchmarks
+ */
+extern int currentStation;
+extern int currentVolume;
+extern int zone2Station;
+extern int zone2Volume;
+extern uint8_t menuZone;
+extern bool monoOutput;
+
+void showMenu(const char *txt);
+int findMenuItem(char key);
+bool runMenuKey(char key);
+void listMenu(void (*cb)(char key, const char *txt, void *ctx), void *ctx);
+const char *menuText(int item);
@@ -0,0 +1,9 @@
+#pragma once
+#include <Arduino.h>
+
+/**
+ * The menu item of each key, so a key from the monitor or the web UI
+ * finds its action with one table lookup instead of walking the menu
+ */
+void menuKeySet(char key, uint8_t item);
+int menuKeyFind(char key);
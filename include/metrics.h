@@ -0,0 +1,60 @@
+#pragma once
+#include <Arduino.h>
+
+/**
+ * Counters and gauges shown with the menu command 'M'.
+ * To add a metric, append a line with its id and label.
+ */
+#define METRICS(X) \
+  X(HTTP_REQUESTS,          "http requests") \
+  X(HTTP_CONNECTS,          "http connections opened") \
+  X(HTTP_REUSED,            "http connections reused") \
+  X(TLS_HANDSHAKES_AVOIDED, "tls handshakes avoided") \
+  X(HTTP_POOL_EXHAUSTED,    "http pool exhausted") \
+  X(MIRROR_FRAMES_1,        "frames from mirror 1") \
+  X(MIRROR_FRAMES_2,        "frames from mirror 2") \
+  X(MIRROR_SWITCHES,        "mirror switches") \
+  X(SPLICE_JUMPS,           "splices with a jump") \
+  X(MIRROR_RECONNECTS,      "mirror reconnects") \
+  X(MIRROR_RESYNCS,         "mirror resyncs") \
+  X(MIRROR_SKIPPED_BYTES,   "mirror bytes skipped") \
+  X(STREAM_RTT_MS,          "stream rtt ms") \
+  X(PREBUFFER_FILL_MS,      "prebuffer fill ms") \
+  X(RCV_WINDOW_STEADY,      "steady rcv window needed bytes") \
+  X(RACE_FALLBACKS,         "connects won by other address") \
+  X(CONCEALED_FRAMES,       "concealed mp3 frames") \
+  X(RESYNC_MS_LAST,         "last resync ms") \
+  X(RESYNC_MS_MAX,          "max resync ms") \
+  X(AUDIO_CPU_US_PER_S,     "audio cpu us per s") \
+  X(AUDIO_CPU_MP3,          "audio cpu us per s mp3") \
+  X(AUDIO_CPU_AAC,          "audio cpu us per s aac") \
+  X(CPU_MHZ,                "cpu clock mhz") \
+  X(AUDIO_LOOPS_PER_S,      "audio loop calls per s") \
+  X(REFILL_JITTER_US,       "max refill jitter us") \
+  X(ZONE1_CPU_US_PER_S,     "zone 1 cpu us per s") \
+  X(ZONE2_CPU_US_PER_S,     "zone 2 cpu us per s") \
+  X(ZONE2_RAM_BYTES,        "zone 2 ram bytes") \
+  X(DISPLAY_BYTES_PER_S,    "display bytes per s") \
+  X(DISPLAY_RENDER_US,      "display render us per frame") \
+  X(DISPLAY_FLUSH_US,       "display flush us per frame") \
+  X(WEB_REQUESTS,           "web requests") \
+  X(WEB_NOT_MODIFIED,       "web page not modified") \
+  X(WEB_BYTES_SENT,         "web bytes sent") \
+  X(WEB_PAGE_US,            "web page serve us") \
+  X(PROBE_RTT_MS,           "probe rtt ms") \
+  X(PROBE_KBPS,             "probe throughput kbit/s") \
+  X(REC_BYTES,              "recorded bytes") \
+  X(REC_THROTTLE_EVENTS,    "recorder held back") \
+  X(REC_THROTTLED_MS,       "recorder held back ms") \
+  X(REC_WRITE_MAX_MS,       "recorder longest flash write ms") \
+  X(REC_SLOW_WRITES,        "recorder writes over stall budget") \
+  X(SCHED_WAKEUPS,          "scheduler wake ups")
+
+#define METRIC_ID(id, label) id,
+enum Metric : uint8_t { METRICS(METRIC_ID) METRIC_COUNT };
+#undef METRIC_ID
+
+void metricAdd(Metric m, int32_t n = 1);
+void metricSet(Metric m, int32_t value);
+int32_t metricGet(Metric m);
+void showMetrics(const char*);
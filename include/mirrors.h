@@ -0,0 +1,9 @@
+#pragma once
+#include <Arduino.h>
+
+class Audio;
+
+/**
+ * Plays a station received from two mirrors at once over the splicer
+ */
+bool connectMirrored(Audio &out, const char *url);
@@ -0,0 +1,9 @@
+#pragma once
+#include <Arduino.h>
+
+#define SYNC_CHAIN 3   // consecutive headers required to accept a sync point
+
+struct Mp3Header { uint8_t version; uint8_t layer; uint32_t sampleRate; uint16_t frameLen; };
+
+bool parseMp3Header(const uint8_t *p, Mp3Header &h);
+int32_t mp3FindSync(const uint8_t *buf, size_t len);
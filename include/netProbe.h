@@ -0,0 +1,9 @@
+#pragma once
+#include <Arduino.h>
+
+/**
+ * Connect time, throughput and retransmissions of the network path
+ * to a probe server
+ */
+bool setProbeServer(const char *hostPort);
+void networkProbe(const char *txt);
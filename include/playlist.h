@@ -0,0 +1,8 @@
+#pragma once
+#include <Arduino.h>
+
+/**
+ * The stream URL of an M3U or PLS playlist
+ */
+bool parsePlaylist(const char *body, char *url, size_t size);
+const char *resolvePlaylist(const char *url);
@@ -0,0 +1,9 @@
+#pragma once
+#include <Arduino.h>
+
+/**
+ * CPU clock for full quality or low power playback, and the supply
+ * current of the board if an INA219 measures it
+ */
+void applyPowerMode(bool lowPower);
+int32_t supplyCurrentMa();
@@ -0,0 +1,9 @@
+#pragma once
+#include <Arduino.h>
+
+/**
+ * Report of the time a stream needs to fill its buffer after the start
+ */
+void initPrebufferReport();
+void streamStarted(const char *url);
+void prebufferPoll();
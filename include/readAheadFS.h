@@ -0,0 +1,20 @@
+#pragma once
+#include <FS.h>
+
+/**
+ * A thin fs::FS wrapper which serves reads from large, aligned 
+ * chunks of the underlying file system. The audio library reads 
+ * the input buffer in small, odd sized pieces, which costs SPIFFS 
+ * and LittleFS a lookup per call. With the read-ahead layer each 
+ * flash access transfers a whole chunk starting at a multiple of 
+ * the chunk size, reads larger than a chunk bypass the buffer.
+ * 
+ * Usage: ReadAheadFS littlefsRA(LittleFS);
+ *        audio.connecttoFS(littlefsRA, "/stereotest440-445.mp3");
+ */
+class ReadAheadFS : public fs::FS
+{
+  public:
+    static constexpr size_t DEFAULT_CHUNK_SIZE = 4096;
+    ReadAheadFS(fs::FS &base, size_t chunkSize = DEFAULT_CHUNK_SIZE);
+};
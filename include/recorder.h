@@ -0,0 +1,9 @@
+#pragma once
+#include <Arduino.h>
+
+/**
+ * Records a stream to LittleFS in a task of its own, without taking 
+ * bandwidth or flash time from the playing stream
+ */
+void toggleRecording(const char *url);
+const char *lastRecording();
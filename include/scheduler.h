@@ -0,0 +1,20 @@
+#pragma once
+#include <Arduino.h>
+
+/**
+ * Periodic and delayed background work. Timers live in a hierarchical
+ * timer wheel with 10 ms ticks, insert and expiry are O(1). An expired
+ * timer puts its job into a queue per priority, which a task on core 0
+ * works off, high priority first. Between deadlines the task sleeps.
+ * The runtime of every job is accounted and shown with showJobs().
+ *
+ * Usage: addTimer("pool", 1000, 1000, JOB_LOW, [](void *) { httpPoolMaintain(); });
+ */
+enum JobPriority : uint8_t { JOB_HIGH, JOB_NORMAL, JOB_LOW, JOB_PRIORITIES };
+
+typedef void (*JobFn)(void *ctx);
+
+int addTimer(const char *name, uint32_t firstMs, uint32_t periodMs, JobPriority prio, JobFn fn, void *ctx = nullptr);
+void startScheduler();
+uint32_t runDueJobs();
+void showJobs(const char *txt);
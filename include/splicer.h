@@ -0,0 +1,113 @@
+#pragma once
+#include <Arduino.h>
+
+/**
+ * Splicing of one MP3 station received over two paths. Each path feeds
+ * its bytes into a MirrorQueue, which cuts them into frames and keeps a
+ * frame only if the next header follows where its length says. The
+ * Splicer hands the frames to the decoder in order: a frame is known by
+ * a hash of its bytes, so the copy of a frame which arrives over the
+ * other path is recognised and dropped, and the path which holds the
+ * next frame continues the stream. When one path stalls, the other one
+ * bridges the gap at a frame boundary without a jump in the audio.
+ *
+ * Both paths must carry the output of the same encoder, e.g. two relays
+ * of the same source. Otherwise no frame matches and the splicer only
+ * jumps to the other path at a frame boundary after SPLICE_WAIT_MS.
+ */
+#define MIRRORS          2
+#define FRAME_MAX_LEN    1441   // 320 kbit/s at 32 kHz with padding
+#define QUEUE_FRAMES     64
+#define HISTORY_FRAMES   128    // frames given out, which are dropped when they arrive again
+#define SPLICE_WAIT_MS   500    // wait for the next frame before jumping to the other path
+#define ICY_META_MAX     512    // bytes of a metadata block which are examined
+#define ICY_TITLE_MAX    128
+
+struct SpliceFrame { uint32_t hash; uint16_t len; bool gap; };   // gap: bytes were lost before the frame
+
+class MirrorQueue
+{
+  public:
+    MirrorQueue(uint8_t *ring = nullptr, size_t ringSize = 0) { begin(ring, ringSize); }
+    void begin(uint8_t *ring, size_t ringSize);
+    void reset();
+    void cut();
+
+    // receiver side
+    size_t space() const { return sizeof(_raw) - _rawLen; }
+    void append(const uint8_t *buf, size_t len);
+
+    // splicer side
+    bool head(SpliceFrame &f) const { return at(0, f); }
+    bool at(uint8_t k, SpliceFrame &f) const;
+    void pop(uint8_t *out);
+    bool full() const { return _count == QUEUE_FRAMES; }
+
+    uint32_t resyncs      = 0;   // times the sync was lost and found again
+    uint32_t skippedBytes = 0;   // bytes dropped while searching
+    uint32_t lastSkipped  = 0;   // bytes dropped by the last resync
+
+  private:
+    void parse();
+    bool push(const uint8_t *p, uint16_t len);
+
+    uint8_t  _raw[4 * FRAME_MAX_LEN];   // room for a chain of headers to resync on
+    size_t   _rawLen = 0;
+    bool     _synced = false;
+    bool     _everSynced = false;
+    bool     _gap = true;
+    uint8_t *_ring = nullptr;
+    size_t   _ringSize = 0, _ringHead = 0, _ringUsed = 0;
+    SpliceFrame _frames[QUEUE_FRAMES];
+    uint8_t  _first = 0, _count = 0;
+};
+
+class Splicer
+{
+  public:
+    Splicer(MirrorQueue &a, MirrorQueue &b) : _q{ &a, &b } { reset(); }
+    void reset();
+    size_t next(uint8_t *out, uint32_t msNow);
+
+    uint32_t frames[MIRRORS];   // frames given out from each path
+    uint32_t switches;          // the other path continued the stream
+    uint32_t jumps;             // no path continued, jumped at a frame boundary
+
+  private:
+    void align(uint8_t i);
+    void catchUp(uint8_t i);
+
+    MirrorQueue *_q[MIRRORS];
+    uint32_t _history[HISTORY_FRAMES];   // hashes of the frames given out, by number
+    uint32_t _seq;               // number of the next frame
+    bool     _inStep[MIRRORS];
+    uint32_t _headSeq[MIRRORS];  // number of the oldest frame of a path in step
+    int8_t   _active;            // path of the last frame, -1 before the first
+    uint32_t _msWait;            // since when no path continues the stream
+    bool     _waiting;
+};
+
+
+/**
+ * The ICY metadata of a path. Asked with "Icy-MetaData: 1" the server 
+ * inserts a block after every metaInt bytes of audio: a length byte, 
+ * then 16 times as many bytes of text like StreamTitle='...';. strip() 
+ * removes the blocks in place and keeps the last title.
+ */
+class IcyStripper
+{
+  public:
+    void begin(uint32_t metaInt);
+    size_t strip(uint8_t *buf, size_t len);
+    bool newTitle(char *out, size_t size);
+
+  private:
+    void parseMeta();
+
+    uint32_t _metaInt = 0, _audioLeft = 0;
+    bool     _inMeta = false;
+    uint16_t _metaLeft = 0, _metaLen = 0;
+    char     _meta[ICY_META_MAX + 1];
+    char     _title[ICY_TITLE_MAX] = "";
+    bool     _titleNew = false;
+};
@@ -0,0 +1,11 @@
+#pragma once
+#include <Arduino.h>
+#include <time.h>
+
+/**
+ * The stream titles of each station with the time they started
+ */
+void initTitleHistory();
+void recordTitle(uint8_t station, const char *title);
+uint8_t queryTitleHistory(uint8_t station, uint32_t maxAge, void (*cb)(time_t t, const char *title, void *ctx), void *ctx);
+void showTitleHistory(uint8_t station);
@@ -0,0 +1,11 @@
+#pragma once
+#include <Arduino.h>
+
+class Audio;
+
+/**
+ * Text to speech, served from LittleFS when the phrase was rendered before
+ */
+void addTtsJob(const char *txt, const char *lang);
+bool ttsPrerenderPoll();
+void speak(Audio &out, const char *txt, const char *lang);
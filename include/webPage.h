@@ -0,0 +1,56 @@
+// generated by web/embed.py from web/index.html, do not edit
+#pragma once
+#include <Arduino.h>
+
+#define WEB_PAGE_ETAG "\"fc94592ec7ea179d\""
+
+static const uint8_t webPageGz[742] PROGMEM =
+{
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x7d, 0x54, 0x6d, 0x4f, 0xdb, 0x30,
+  0x10, 0xfe, 0x9e, 0x5f, 0x71, 0x2b, 0x68, 0x49, 0x46, 0x9b, 0xb6, 0xb0, 0x4a, 0xa8, 0x4d, 0x3b,
+  0x69, 0x80, 0x34, 0x24, 0x26, 0x10, 0x74, 0x9a, 0xb6, 0x6f, 0x6e, 0x72, 0x21, 0x1e, 0x8e, 0x5d,
+  0xc5, 0x97, 0x42, 0x41, 0xfd, 0xef, 0x3b, 0x37, 0x49, 0xe9, 0x98, 0xc4, 0x17, 0x3b, 0xbe, 0x7b,
+  0xee, 0xed, 0xb9, 0xbb, 0xc4, 0x1f, 0xce, 0xaf, 0xcf, 0xe6, 0xbf, 0x6e, 0x2e, 0x20, 0xa7, 0x42,
+  0xcd, 0xbc, 0xb8, 0xbd, 0x50, 0xa4, 0x7c, 0x15, 0x48, 0x02, 0x92, 0x5c, 0x94, 0x16, 0x69, 0xda,
+  0xa9, 0x28, 0xeb, 0x9d, 0x76, 0x5a, 0xb1, 0x16, 0x05, 0x4e, 0x3b, 0x2b, 0x89, 0x8f, 0x4b, 0x53,
+  0x52, 0x07, 0x12, 0xa3, 0x09, 0x35, 0xc3, 0x1e, 0x65, 0x4a, 0xf9, 0x34, 0xc5, 0x95, 0x4c, 0xb0,
+  0xb7, 0x7d, 0x74, 0x41, 0x6a, 0x49, 0x52, 0xa8, 0x9e, 0x4d, 0x84, 0xc2, 0xe9, 0xd0, 0x39, 0x21,
+  0x49, 0x0a, 0x67, 0x17, 0x77, 0x37, 0x27, 0xc7, 0xf0, 0x13, 0x17, 0x70, 0x2b, 0x52, 0x69, 0xe2,
+  0x7e, 0x2d, 0xf6, 0x62, 0x4b, 0x6b, 0x77, 0x2f, 0x4c, 0xba, 0x86, 0x17, 0xc8, 0xd8, 0x79, 0x2f,
+  0x13, 0x85, 0x54, 0xeb, 0x31, 0x58, 0xa1, 0x6d, 0xcf, 0x62, 0x29, 0xb3, 0x09, 0x14, 0xa2, 0xbc,
+  0x97, 0x7a, 0x0c, 0x43, 0x2c, 0xdc, 0xe3, 0xa9, 0x0e, 0x38, 0x86, 0xcf, 0x03, 0x27, 0xd8, 0x78,
+  0x8b, 0x8a, 0xc8, 0x68, 0xf6, 0xd0, 0x02, 0x07, 0xd1, 0xb1, 0xd3, 0x2c, 0x45, 0x9a, 0x4a, 0x7d,
+  0xef, 0xde, 0x23, 0x2c, 0xf8, 0x3c, 0xad, 0xf1, 0x07, 0x96, 0x04, 0x55, 0xb6, 0x0d, 0x69, 0xe5,
+  0x33, 0xb2, 0xf3, 0xda, 0xe6, 0xd5, 0xc5, 0xd6, 0x64, 0x0b, 0xcf, 0xa5, 0x25, 0x53, 0xba, 0x14,
+  0x13, 0xa3, 0x4c, 0x39, 0x86, 0x83, 0xd1, 0x68, 0xb4, 0x73, 0xdf, 0x53, 0x98, 0xd1, 0xce, 0x7e,
+  0xe3, 0xc5, 0xfd, 0xa6, 0xac, 0xb8, 0xdf, 0x30, 0xec, 0xea, 0x73, 0x7c, 0x0f, 0xff, 0x67, 0x82,
+  0x65, 0x5e, 0x9c, 0xca, 0x15, 0xc8, 0x74, 0xda, 0xa9, 0xd3, 0xea, 0xcc, 0x3e, 0xe6, 0xa8, 0x94,
+  0x5c, 0x4e, 0xe2, 0x3e, 0x6b, 0xf6, 0xf4, 0x0f, 0xb8, 0x66, 0x6d, 0x2b, 0xcd, 0x4f, 0x66, 0x73,
+  0xc7, 0xa3, 0x05, 0x93, 0x01, 0xe5, 0x08, 0x4a, 0x58, 0x82, 0xdc, 0x54, 0x25, 0xbb, 0x3d, 0x61,
+  0x40, 0xa5, 0xb6, 0x56, 0x4d, 0xf6, 0xce, 0xb0, 0x72, 0x6d, 0xb7, 0x49, 0x29, 0x97, 0x34, 0xf3,
+  0xb8, 0x97, 0x8c, 0x3f, 0x84, 0x29, 0xa3, 0x60, 0x3a, 0x83, 0xd4, 0x24, 0x55, 0xc1, 0xcd, 0x8d,
+  0xee, 0x91, 0x2e, 0x14, 0xba, 0xcf, 0xaf, 0xeb, 0xcb, 0x34, 0x90, 0x69, 0x38, 0xf1, 0xbc, 0xac,
+  0xd2, 0x09, 0x49, 0x66, 0x99, 0x93, 0x08, 0x1e, 0x42, 0x78, 0xf1, 0x00, 0x32, 0xa4, 0x24, 0x0f,
+  0xfc, 0xbe, 0x58, 0xca, 0x3e, 0x8b, 0xbf, 0x3c, 0x4c, 0x7d, 0x38, 0x02, 0xd4, 0x89, 0x49, 0xf1,
+  0xc7, 0xed, 0xe5, 0x99, 0x29, 0x96, 0x46, 0xb3, 0x1b, 0xc6, 0x77, 0x5d, 0x77, 0x90, 0x72, 0x93,
+  0x8e, 0xc1, 0xbf, 0xb9, 0xbe, 0x9b, 0xfb, 0xb0, 0x09, 0x23, 0xce, 0x5a, 0x07, 0x75, 0xd5, 0x1c,
+  0x63, 0xb3, 0x17, 0xa5, 0x16, 0x06, 0xff, 0xc7, 0xa9, 0x15, 0x7e, 0x63, 0x5b, 0xba, 0xc4, 0xcb,
+  0xe8, 0x8f, 0x35, 0x3a, 0x08, 0x5b, 0x7f, 0x4e, 0xe6, 0xcc, 0x00, 0x0e, 0x03, 0xff, 0x15, 0x8f,
+  0x4f, 0x74, 0x56, 0x8f, 0x2f, 0x97, 0xec, 0xff, 0xe6, 0xcc, 0xc0, 0xa5, 0x6b, 0xa3, 0x67, 0xf7,
+  0x79, 0x04, 0xfe, 0xb8, 0x79, 0x3b, 0x13, 0x97, 0x03, 0x8b, 0xba, 0xb0, 0x32, 0x8a, 0x59, 0x69,
+  0x34, 0xf5, 0x63, 0xd2, 0xfa, 0x6e, 0x98, 0x65, 0xe7, 0x52, 0x6b, 0x2c, 0xbf, 0xcd, 0xbf, 0x5f,
+  0x39, 0xd7, 0x7e, 0x0d, 0xc8, 0x4c, 0x09, 0x41, 0x4d, 0x32, 0xb9, 0x16, 0xd9, 0xa8, 0xc1, 0x87,
+  0x4d, 0x76, 0x00, 0xb5, 0x56, 0x49, 0xb6, 0xda, 0xb1, 0x9f, 0x94, 0x28, 0x08, 0x9b, 0x06, 0x04,
+  0xbe, 0x92, 0x7e, 0x38, 0x69, 0xe0, 0x4a, 0xbe, 0xa9, 0x42, 0xe3, 0x23, 0x9c, 0x33, 0x3a, 0xa0,
+  0x88, 0x24, 0x67, 0xf9, 0x09, 0x86, 0x83, 0xc1, 0x80, 0x6b, 0x35, 0x57, 0xc6, 0x2d, 0xe1, 0x9c,
+  0x85, 0x77, 0x54, 0xf2, 0x90, 0x06, 0x61, 0x64, 0x15, 0xef, 0x6a, 0x30, 0xe8, 0xc2, 0x28, 0x74,
+  0xa5, 0xc1, 0xb6, 0x26, 0x67, 0xc8, 0x33, 0xd4, 0x46, 0xf8, 0xa7, 0x28, 0xb1, 0x5c, 0xa2, 0x4e,
+  0xcf, 0x72, 0xa9, 0xd2, 0x40, 0xc9, 0x26, 0x8b, 0x0d, 0x9f, 0x9b, 0xa6, 0x59, 0x7b, 0x6d, 0xe1,
+  0x64, 0xab, 0xf7, 0x9a, 0x22, 0x09, 0x8b, 0x5d, 0x63, 0xf6, 0x98, 0x29, 0x1c, 0x33, 0x5b, 0x65,
+  0xcb, 0x4a, 0x2d, 0x5f, 0xbc, 0x43, 0x49, 0xbd, 0xee, 0x2d, 0x2d, 0x8b, 0x37, 0x9c, 0x14, 0x11,
+  0x3d, 0x51, 0xab, 0x32, 0x3a, 0xe1, 0xaa, 0x1f, 0x58, 0xcc, 0xa3, 0xc4, 0xd1, 0xdd, 0xf0, 0x16,
+  0x11, 0x9f, 0xe1, 0xae, 0x89, 0x6e, 0xa9, 0xde, 0x14, 0xbb, 0xd8, 0x6a, 0x37, 0x9e, 0xab, 0xb3,
+  0x1d, 0x44, 0xfe, 0x42, 0xba, 0xe4, 0x20, 0xe5, 0x4a, 0xa8, 0x66, 0x66, 0x99, 0x4a, 0x47, 0xf7,
+  0xc4, 0xad, 0x7c, 0xb3, 0x54, 0x71, 0xbf, 0x59, 0xf6, 0x7e, 0xfd, 0x93, 0xfd, 0x0b, 0x0e, 0x01,
+  0x7c, 0xeb, 0x7c, 0x05, 0x00, 0x00,
+};
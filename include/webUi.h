@@ -0,0 +1,7 @@
+#pragma once
+
+/**
+ * The web page and its JSON API, which run the same actions as the keys
+ */
+void initWebUi();
+void webUiPoll();
@@ -0,0 +1,215 @@
+#include <Arduino.h>
+#include <freertos/semphr.h>
+#include "Audio.h"
+#include "metrics.h"
+#include "clock.h"
+#include "memPolicy.h"
+#include "audioTask.h"
+
+#define AUDIO_TASK_CORE     1
+#define AUDIO_TASK_PRIORITY 3       // above loop() and the background tasks
+#define I2S_DMA_FRAMES      512     // frames per DMA buffer of the audio library
+#define MIN_SLEEP_MS        1
+
+// I2S1 pins of the second zone
+#define ZONE2_LRC           GPIO_NUM_13
+#define ZONE2_BCLK          GPIO_NUM_14
+#define ZONE2_DOUT          GPIO_NUM_33
+
+static SemaphoreHandle_t audioMutex = xSemaphoreCreateRecursiveMutex();
+static TaskHandle_t audioTask = nullptr;
+static Audio *zones[NBR_ZONES] = { &audio, nullptr };
+static volatile uint8_t activeZone = 0;
+static volatile bool paused = false;
+static uint32_t zone2HeapBefore = 0;   // free heap before zone 2 was created, 0 once reported
+
+// status of zone 1, published by the audio task after each loop
+static volatile bool     statusRunning     = false;
+static volatile uint8_t  statusFillPercent = 0;
+static volatile uint32_t statusBitRate     = 0;
+static volatile uint32_t statusBufferBytes = 0;
+
+/**
+ * The audio objects are used by the audio task and by the menu 
+ * actions in loop(), which hold this lock for each short action.
+ * Background tasks and jobs never take it, they read the status 
+ * below. Nothing holds it for long, see pauseAudioTask().
+ */
+void audioLock()   { xSemaphoreTakeRecursive(audioMutex, portMAX_DELAY); }
+void audioUnlock() { xSemaphoreGiveRecursive(audioMutex); }
+
+bool     audioRunning()     { return statusRunning; }
+uint8_t  audioFillPercent() { return statusFillPercent; }
+uint32_t audioBitRate()     { return statusBitRate; }
+uint32_t audioBufferBytes() { return statusBufferBytes; }
+
+
+static void publishStatus()
+{
+  uint32_t size = audio.getInBufferSize();
+  statusRunning     = audio.isRunning();
+  statusFillPercent = size ? (uint64_t)audio.inBufferFilled() * 100 / size : 0;
+  statusBitRate     = statusRunning ? audio.getBitRate() : 0;
+  statusBufferBytes = size;
+}
+
+
+/**
+ * Stop the audio task from calling into the audio objects, e.g. 
+ * while a benchmark drives audio.loop() itself from loop(). Taking 
+ * the lock once waits for the running audio.loop() to return.
+ */
+void pauseAudioTask(bool pause)
+{
+  audioLock();
+  paused = pause;
+  if (pause) statusRunning = false;
+  audioUnlock();
+}
+
+
+/**
+ * Wake the audio task at once, e.g. after a new station was selected
+ */
+void wakeAudioTask()
+{
+  if (audioTask) xTaskNotifyGive(audioTask);
+}
+
+
+/**
+ * The audio object of a zone. The second zone drives I2S1 and is 
+ * created on first use. Its RAM is reported once it decodes, when 
+ * the decoder and the I2S buffers have been allocated as well.
+ */
+Audio &zoneAudio(uint8_t zone)
+{
+  if (zone == 0) return audio;
+  if (zones[1] == nullptr)
+  {
+    zone2HeapBefore = ESP.getFreeHeap();
+    zones[1] = new Audio(false, 3, 1);   // I2S_NUM_1
+    zones[1]->setPinout(ZONE2_BCLK, ZONE2_LRC, ZONE2_DOUT);
+    placeStreamBuffer(*zones[1]);
+    zones[1]->setVolume(21);             // the volume is applied in the DSP stage
+  }
+  return *zones[1];
+}
+
+
+static void reportZone2Ram()
+{
+  if (zone2HeapBefore == 0 || !zones[1]->isRunning() || zones[1]->getSampleRate() == 0) return;
+  metricSet(ZONE2_RAM_BYTES, zone2HeapBefore - ESP.getFreeHeap());
+  zone2HeapBefore = 0;
+}
+
+
+/**
+ * The library names its AAC decoder after the container, 
+ * AAC for ADTS, AACP for HE-AAC and M4A for MP4
+ */
+static bool isAac(const char *codec)
+{
+  return strcmp(codec, "AAC") == 0 || strcmp(codec, "AACP") == 0 || strcmp(codec, "M4A") == 0;
+}
+
+
+/**
+ * Zone whose audio.loop() is running, callbacks and DSP 
+ * stages use it to tell the zones apart
+ */
+uint8_t currentZone() { return activeZone; }
+
+
+/**
+ * The decoders of the audio library keep their state in globals, so 
+ * both zones must not use the same codec at the same time. The codec 
+ * of a source is guessed from its name.
+ */
+bool zoneCanPlay(uint8_t zone, const char *source)
+{
+  Audio *other = zones[1 - zone];
+  if (other == nullptr || !other->isRunning()) return true;
+  bool aac = strstr(source, "aac") || strstr(source, "AAC") || strstr(source, "m4a");
+  return aac != isAac(other->getCodecname());
+}
+
+
+/**
+ * Time until half of a DMA buffer has been played. Sleeping that 
+ * long leaves the other half as margin, polling more often only 
+ * finds the DMA buffers still full.
+ */
+static uint32_t sleepMs()
+{
+  uint32_t ms = 10;
+  for (auto z : zones)
+  {
+    uint32_t rate = (z && z->isRunning()) ? z->getSampleRate() : 0;
+    if (rate) ms = std::min<uint32_t>(ms, std::max<uint32_t>(MIN_SLEEP_MS, I2S_DMA_FRAMES * 1000 / rate / 2));
+  }
+  return ms;
+}
+
+
+/**
+ * Refill the I2S DMA buffers whenever one is due. The task sleeps 
+ * in between, so the refill no longer depends on how often loop()
+ * is scheduled. Jitter is the deviation of the actual wake up from 
+ * the planned one.
+ */
+static void audioTaskFunc(void *)
+{
+  uint32_t usBusy = 0, calls = 0, usJitterMax = 0, msSecond = clockMs();
+  uint32_t usZone[NBR_ZONES] = {};
+  uint32_t usPlannedWake = micros();
+
+  while (true)
+  {
+    uint32_t usStart = micros();
+    uint32_t jitter = abs((int32_t)(usStart - usPlannedWake));
+    if (jitter > usJitterMax) usJitterMax = jitter;
+
+    audioLock();
+    for (uint8_t z = 0; z < NBR_ZONES && !paused; z++)
+    {
+      if (zones[z] == nullptr) continue;
+      uint32_t us = micros();
+      activeZone = z;
+      zones[z]->loop();
+      usZone[z] += micros() - us;
+    }
+    activeZone = 0;
+    if (!paused) publishStatus();
+    if (!paused && zones[1]) reportZone2Ram();
+    usBusy += micros() - usStart;
+    calls++;
+
+    // CPU time spent in the audio library per second of audio, also per codec
+    if (clockMs() - msSecond >= 1000)
+    {
+      msSecond = clockMs();
+      metricSet(AUDIO_CPU_US_PER_S, usBusy);
+      const char *codec = statusRunning ? audio.getCodecname() : "";
+      if (isAac(codec))                   metricSet(AUDIO_CPU_AAC, usBusy);
+      else if (strcmp(codec, "MP3") == 0) metricSet(AUDIO_CPU_MP3, usBusy);
+      metricSet(AUDIO_LOOPS_PER_S, calls);
+      metricSet(REFILL_JITTER_US, usJitterMax);
+      metricSet(ZONE1_CPU_US_PER_S, usZone[0]);
+      metricSet(ZONE2_CPU_US_PER_S, usZone[1]);
+      usBusy = calls = usJitterMax = usZone[0] = usZone[1] = 0;
+    }
+    uint32_t ms = paused ? 10 : sleepMs();
+    audioUnlock();
+
+    usPlannedWake = micros() + ms * 1000;
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ms))) usPlannedWake = micros();  // woken on purpose
+  }
+}
+
+
+void startAudioTask()
+{
+  xTaskCreatePinnedToCore(audioTaskFunc, "audio", 8192, NULL, AUDIO_TASK_PRIORITY, &audioTask, AUDIO_TASK_CORE);
+}
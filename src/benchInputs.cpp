@@ -0,0 +1,40 @@
+#include <Arduino.h>
+#include "bench.h"
+#include "mp3Sync.h"
+
+/**
+ * Inputs which drive the parsers into their slowest paths, used by 
+ * the board benchmark and the host benchmark in test/bench
+ */
+bool worstCaseMp3(uint8_t i, uint8_t *buf, size_t len)
+{
+  static const uint8_t header[] = { 0xFF, 0xFB, 0x90, 0x64 };  // 128 kbit/s, 44.1 kHz, 417 bytes
+  switch (i)
+  {
+    case 0: for (size_t k = 0; k < len; k++) buf[k] = esp_random(); return true;
+    case 1: memset(buf, 0xFF, len); return true;
+    case 2: // headers one frame apart, every second chain broken just before acceptance
+      memset(buf, 0, len);
+      for (size_t k = 0, n = 0; k + 4 <= len; k += 417, n++) if (n % SYNC_CHAIN != SYNC_CHAIN - 1) memcpy(buf + k, header, 4);
+      return true;
+    case 3: // a syncword candidate at every byte
+      for (size_t k = 0; k < len; k++) buf[k] = k & 1 ? 0xFB : 0xFF;
+      return true;
+  }
+  return false;
+}
+
+bool worstCaseText(uint8_t i, uint8_t *buf, size_t len)
+{
+  switch (i)
+  {
+    case 0: for (size_t k = 0; k < len - 1; k++) buf[k] = 0x80 + k % 32; break;          // cp1252, 3 byte output
+    case 1: for (size_t k = 0; k < len - 1; k++) buf[k] = k % 2 ? 0x80 : 0xC3;            // valid UTF-8 ...
+            buf[len - 2] = 0xC3; break;                                                    // ... broken at the end
+    case 2: for (size_t k = 0; k < len - 1; k++) buf[k] = "File1=x\n"[k % 8]; break;      // pls lines, no url
+    case 3: memset(buf, 'h', len - 1); break;                                              // one endless line
+    default: return false;
+  }
+  buf[len - 1] = '\0';
+  return true;
+}
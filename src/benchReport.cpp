@@ -0,0 +1,70 @@
+#include <Arduino.h>
+#include "bench.h"
+
+static const BenchBaseline *table;
+static size_t tableSize;
+static bool csvOutput;
+static uint8_t results, regressions, unjudged;
+
+
+void benchBegin(const BenchBaseline *baselines, size_t count, bool csv)
+{
+  table = baselines;
+  tableSize = count;
+  csvOutput = csv;
+  results = regressions = unjudged = 0;
+  if (csv) Serial.printf("name,value,unit,baseline,tolerance,verdict\r\n");
+}
+
+bool benchCsv() { return csvOutput; }
+
+
+/**
+ * Compare a result with its baseline
+ */
+static const char *judge(const char *name, uint32_t value, const BenchBaseline *&base)
+{
+  base = nullptr;
+  for (size_t i = 0; i < tableSize; i++) if (strcmp(table[i].name, name) == 0) base = &table[i];
+  if (!base || base->value == 0)
+  {
+    unjudged++;
+    return "no baseline";
+  }
+
+  uint64_t scaled = (uint64_t)value * 100;
+  bool worse = base->higherIsBetter ? scaled < (uint64_t)base->value * (100 - base->tolerancePercent)
+                                    : scaled > (uint64_t)base->value * (100 + base->tolerancePercent);
+  results++;
+  if (worse) regressions++;
+  return worse ? "REGRESSION" : "ok";
+}
+
+
+/**
+ * One line of the report, the same layout on every unit 
+ * so reports can be compared side by side, or as CSV
+ */
+void benchReport(const char *name, uint32_t value, const char *unit)
+{
+  const BenchBaseline *base;
+  const char *verdict = judge(name, value, base);
+  uint32_t baseValue = base ? base->value : 0;
+  uint8_t tolerance  = base ? base->tolerancePercent : 0;
+  if (csvOutput) Serial.printf("%s,%u,%s,%u,%u,%s\r\n", name, value, unit, baseValue, tolerance, verdict);
+  else           Serial.printf("  %-28s %10u %-12s %10u %3u%%  %s\r\n", name, value, unit, baseValue, tolerance, verdict);
+}
+
+
+/**
+ * Print the verdict and return the number of regressions. Without 
+ * any recorded baseline nothing is gated, which is not a pass.
+ */
+uint8_t benchEnd()
+{
+  if (regressions)       Serial.printf("FAILED: %u of %u results worse than their baseline\r\n", regressions, results);
+  else if (results == 0) Serial.printf("UNGATED: none of %u results has a baseline, record them from the CSV report\r\n", unjudged);
+  else if (unjudged)     Serial.printf("PASSED: %u results within their baseline, %u without one\r\n", results, unjudged);
+  else                   Serial.printf("PASSED: %u results within their baseline\r\n", results);
+  return regressions;
+}
@@ -0,0 +1,296 @@
+#include <Arduino.h>
+#include <SPIFFS.h>
+#include <LittleFS.h>
+#include <esp_partition.h>
+#include "Audio.h"
+#include "readAheadFS.h"
+#include "mp3Sync.h"
+#include "bench.h"
+#include "benchBaseline.h"
+#include "audioTask.h"
+#include "fileSystems.h"
+#include "dsp.h"
+#include "charset.h"
+#include "playlist.h"
+#include "menu.h"
+#include "powerMode.h"
+#include "benchmark.h"
+
+#define BENCH_FIXTURE   "/stereotest440-445.mp3"
+#define DECODE_SECONDS  3
+#define COPY_BLOCK      (16 * 1024)
+#define COPY_ROUNDS     64
+#define FLASH_BYTES     (256 * 1024)
+#define PARSE_BYTES     2048
+#define PARSE_RUNS      100
+#define CURRENT_MS      100     // interval of the supply current samples
+
+static uint32_t kbPerSecond(uint32_t bytes, uint32_t us)
+{
+  return us ? (uint64_t)bytes * 1000000 / 1024 / us : 0;
+}
+
+
+/**
+ * Raw SPI flash read of the application partition
+ */
+static void benchFlash()
+{
+  const esp_partition_t *app = esp_partition_find_first(ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_ANY, NULL);
+  uint8_t *buf = (uint8_t *)malloc(4096);
+  if (!app || !buf) { free(buf); return; }
+  uint32_t usStart = micros();
+  for (uint32_t off = 0; off < FLASH_BYTES && off < app->size; off += 4096) esp_partition_read(app, off, buf, 4096);
+  benchReport("flash read", kbPerSecond(std::min<uint32_t>(FLASH_BYTES, app->size), micros() - usStart), "KB/s");
+  free(buf);
+}
+
+
+/**
+ * memcpy bandwidth between buffers allocated with the given capabilities
+ */
+static void benchCopy(const char *name, uint32_t capsFrom, uint32_t capsTo)
+{
+  uint8_t *from = (uint8_t *)heap_caps_malloc(COPY_BLOCK, capsFrom);
+  uint8_t *to   = (uint8_t *)heap_caps_malloc(COPY_BLOCK, capsTo);
+  if (from && to)
+  {
+    memset(from, 0x55, COPY_BLOCK);
+    uint32_t usStart = micros();
+    for (int i = 0; i < COPY_ROUNDS; i++) memcpy(to, from, COPY_BLOCK);
+    benchReport(name, kbPerSecond(COPY_BLOCK * COPY_ROUNDS, micros() - usStart), "KB/s");
+  }
+  heap_caps_free(from);
+  heap_caps_free(to);
+}
+
+
+/**
+ * Worst case cycles per byte of the parsers over generated adversarial 
+ * inputs. A stream of 128 kbit/s delivers 16 bytes per ms, so a parser 
+ * may spend at most a small fraction of 15000 cycles per byte at 240 MHz.
+ */
+static void benchParsers()
+{
+  uint8_t *buf = (uint8_t *)malloc(PARSE_BYTES);
+  char url[256];
+  if (!buf) return;
+  uint32_t worstSync = 0, worstUtf8 = 0, worstPlaylist = 0;
+
+  for (uint8_t i = 0; worstCaseMp3(i, buf, PARSE_BYTES); i++)
+  {
+    uint32_t cycles = ESP.getCycleCount();
+    mp3FindSync(buf, PARSE_BYTES);
+    worstSync = std::max(worstSync, (ESP.getCycleCount() - cycles) / PARSE_BYTES);
+  }
+  for (uint8_t i = 0; worstCaseText(i, buf, PARSE_BYTES); i++)
+  {
+    uint32_t cycles = ESP.getCycleCount();
+    toUtf8((char *)buf, PARSE_BYTES);
+    worstUtf8 = std::max(worstUtf8, (ESP.getCycleCount() - cycles) / PARSE_BYTES);
+    worstCaseText(i, buf, PARSE_BYTES);
+    cycles = ESP.getCycleCount();
+    parsePlaylist((char *)buf, url, sizeof(url));
+    worstPlaylist = std::max(worstPlaylist, (ESP.getCycleCount() - cycles) / PARSE_BYTES);
+  }
+  benchReport("parse mp3 sync worst case", worstSync, "cycles/byte");
+  benchReport("parse charset worst case", worstUtf8, "cycles/byte");
+  benchReport("parse playlist worst case", worstPlaylist, "cycles/byte");
+  free(buf);
+}
+
+
+/**
+ * A typical stream title in Windows-1252 as it arrives in the 
+ * metadata, and the key lookup of each menu command
+ */
+static void benchLookups()
+{
+  uint32_t cycles = ESP.getCycleCount();
+  for (int i = 0; i < PARSE_RUNS; i++) metadataToUtf8("Beyonc\xe9 \x96 D\xe9j\xe0 Vu (Live at Caf\xe9 Z\xfcrich)");
+  benchReport("parse stream title", (ESP.getCycleCount() - cycles) / PARSE_RUNS, "cycles");
+
+  // all printable keys, most of them miss
+  volatile int found = 0;
+  cycles = ESP.getCycleCount();
+  for (char key = ' '; key < 0x7F; key++) found += findMenuItem(key);
+  benchReport("menu dispatch lookup", (ESP.getCycleCount() - cycles) / (0x7F - ' '), "cycles");
+}
+
+
+/**
+ * Play the fixture silently and account the CPU time spent in the 
+ * audio library, which decodes and writes to I2S as fast as the DMA 
+ * buffers drain. The loop runs in real time, so the time per second 
+ * of audio follows directly. Returns 0 if the fixture does not play.
+ * With maAvg the average supply current is sampled, -1 without sensor.
+ */
+static uint32_t playFixture(bool mono, uint32_t &framesPerSecond, int32_t *maAvg = nullptr)
+{
+  uint8_t volume = audio.getVolume();
+  audio.setVolume(0);
+  audio.forceMono(mono);
+  uint32_t usBusy = 0, ms = 0;
+  int32_t maSum = 0, samples = 0;
+  if (audio.connecttoFS(littlefsRA, BENCH_FIXTURE)) 
+  {
+    uint32_t msStart = millis(), msSample = msStart;
+    while (millis() - msStart < DECODE_SECONDS * 1000 && audio.isRunning())
+    {
+      uint32_t us = micros();
+      audio.loop();
+      usBusy += micros() - us;
+      if (maAvg && millis() - msSample >= CURRENT_MS)
+      {
+        msSample = millis();
+        int32_t ma = supplyCurrentMa();
+        if (ma >= 0) { maSum += ma; samples++; }
+      }
+      delay(1);
+    }
+    ms = millis() - msStart;
+    framesPerSecond = audio.getSampleRate() / 1152;
+    audio.stopSong();
+  }
+  audio.forceMono(monoOutput);
+  audio.setVolume(volume);
+  if (maAvg) *maAvg = samples ? maSum / samples : -1;
+  return ms ? (uint64_t)usBusy * 1000 / ms : 0;
+}
+
+
+static void benchDecode()
+{
+  uint32_t framesPerSecond = 0;
+  uint32_t usPerSecond = playFixture(false, framesPerSecond);
+  if (usPerSecond == 0) return;
+  benchReport("mp3 decode + i2s write", usPerSecond, "us/s audio");
+  benchReport("mp3 play per frame", framesPerSecond ? usPerSecond / framesPerSecond : 0, "us/frame");
+  benchReport("mp3 play speed", 1000000 / usPerSecond, "x realtime");
+}
+
+
+/**
+ * forceMono() mixes both channels after the stereo decode, so mono 
+ * output may save at most the I2S side. Measure what it really saves.
+ */
+static void benchMono()
+{
+  uint32_t framesPerSecond;
+  uint32_t usStereo = playFixture(false, framesPerSecond);
+  uint32_t usMono   = playFixture(true, framesPerSecond);
+  if (usStereo == 0 || usMono == 0) return;
+  benchReport("mp3 play stereo",       usStereo, "us/s audio");
+  benchReport("mp3 play forced mono",  usMono, "us/s audio");
+  benchReport("forced mono saving",    usMono < usStereo ? usStereo - usMono : 0, "us/s audio");
+}
+
+
+/**
+ * CPU time and supply current while playing at the CPU clock of 
+ * either power mode. Both modes decode the full bandwidth, so only 
+ * the headroom and the current differ. The current needs an INA219.
+ */
+static void benchPowerModes()
+{
+  uint32_t mhzBefore = getCpuFrequencyMhz();
+  for (bool low : { false, true })
+  {
+    applyPowerMode(low);
+    uint32_t framesPerSecond;
+    int32_t ma;
+    uint32_t usPerSecond = playFixture(false, framesPerSecond, &ma);
+    if (usPerSecond == 0) break;
+    char name[32];
+    snprintf(name, sizeof(name), "play at %u MHz", getCpuFrequencyMhz());
+    benchReport(name, usPerSecond, "us/s audio");
+    snprintf(name, sizeof(name), "supply at %u MHz", getCpuFrequencyMhz());
+    if (ma >= 0)         benchReport(name, ma, "mA");
+    else if (!benchCsv()) Serial.printf("  %-28s %10s\r\n", name, "no INA219");
+  }
+  setCpuFrequencyMhz(mhzBefore);
+}
+
+
+/**
+ * Measure the board without network: flash, file systems, memory, 
+ * DSP stages, parsers, lookups and the decode and I2S path. Each 
+ * result is compared with its baseline. The stream is stopped.
+ */
+void runBenchmarks(bool csv)
+{
+  audio.stopSong();
+
+  Serial.printf("\r\nBenchmark %s rev %d, %u MHz, flash %u MB @ %u MHz, psram %u KB\r\n",
+                ESP.getChipModel(), ESP.getChipRevision(), getCpuFrequencyMhz(),
+                ESP.getFlashChipSize() >> 20, ESP.getFlashChipSpeed() / 1000000, ESP.getPsramSize() >> 10);
+  benchBegin(benchBaselines, sizeof(benchBaselines) / sizeof(benchBaselines[0]), csv);
+  benchFlash();
+  benchReport("spiffs read",             readThroughput(SPIFFS, BENCH_FIXTURE), "KB/s");
+  benchReport("littlefs read",           readThroughput(LittleFS, BENCH_FIXTURE), "KB/s");
+  benchReport("littlefs read-ahead read", readThroughput(littlefsRA, BENCH_FIXTURE), "KB/s");
+  benchCopy("dram copy", MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  if (psramFound())
+  {
+    benchCopy("psram copy",         MALLOC_CAP_SPIRAM, MALLOC_CAP_SPIRAM);
+    benchCopy("dram to psram copy", MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT, MALLOC_CAP_SPIRAM);
+  }
+  benchmarkDsp(benchReport);
+  benchParsers();
+  benchLookups();
+  benchDecode();
+  benchMono();
+  benchPowerModes();
+  benchEnd();
+}
+
+
+/**
+ * Corrupt copies of the stereotest file with bursts of random bytes and
+ * compare how far behind the burst the chain validated resync and a plain
+ * syncword scan lock, and how often they lock onto a false frame.
+ */
+void resyncSelfTest(const char* txt)
+{
+  const int trials = 50, burst = 64;
+  File f = LittleFS.open(BENCH_FIXTURE, FILE_READ);
+  if (!f) return;
+  size_t len = f.size();
+  uint8_t *orig = (uint8_t *)malloc(len);
+  uint8_t *buf  = (uint8_t *)malloc(len);
+  bool    *isFrame = (bool *)calloc(len, sizeof(bool));
+  if (!orig || !buf || !isFrame || f.read(orig, len) != len) 
+  {
+    free(orig); free(buf); free(isFrame);
+    return;
+  }
+
+  // mark the true frame boundaries of the intact file
+  Mp3Header h;
+  for (int32_t pos = mp3FindSync(orig, len); pos >= 0 && pos + 4 <= (int32_t)len && parseMp3Header(orig + pos, h); pos += h.frameLen)
+    isFrame[pos] = true;
+
+  uint32_t chainBytes = 0, naiveBytes = 0, usChain = 0;
+  int chainFalse = 0, naiveFalse = 0;
+  for (int t = 0; t < trials; t++)
+  {
+    memcpy(buf, orig, len);
+    size_t at = 1024 + esp_random() % (len - 8192);
+    for (int i = 0; i < burst; i++) buf[at + i] = esp_random();
+
+    uint32_t us = micros();
+    int32_t c = mp3FindSync(buf + at, len - at);
+    usChain += micros() - us;
+    int32_t n = 0;
+    while (at + n + 4 <= len && !parseMp3Header(buf + at + n, h)) n++;
+
+    chainBytes += c >= 0 ? c : len - at;
+    naiveBytes += n;
+    if (c < 0 || !isFrame[at + c]) chainFalse++;
+    if (!isFrame[at + n]) naiveFalse++;
+  }
+  Serial.printf("\r\nResync after %d corrupted bursts of %d bytes:\r\n", trials, burst);
+  Serial.printf("  header chain : %5u bytes avg, %2d false locks, %u us avg\r\n", chainBytes / trials, chainFalse, usChain / trials);
+  Serial.printf("  syncword only: %5u bytes avg, %2d false locks\r\n", naiveBytes / trials, naiveFalse);
+  free(orig); free(buf); free(isFrame);
+}
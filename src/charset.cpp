@@ -0,0 +1,120 @@
+#include <Arduino.h>
+#include "charset.h"
+
+#define METADATA_MAX 256   // bytes incl. terminator for a converted metadata string
+
+/**
+ * Length of a UTF-8 sequence by its lead byte, 0 = invalid lead byte
+ * (continuation bytes 0x80..0xBF, overlong 0xC0/0xC1, > U+10FFFF)
+ */
+static const uint8_t utf8SeqLen[256] =
+{
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,  // 0x00
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,  // 0x20
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,  // 0x40
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,  // 0x60
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  // 0x80
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,  // 0xA0
+  0,0,2,2,2,2,2,2,2,2,2,2,2,2,2,2, 2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,  // 0xC0
+  3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3, 4,4,4,4,4,0,0,0,0,0,0,0,0,0,0,0,  // 0xE0
+};
+
+/**
+ * Windows-1252 code points of the bytes 0x80..0x9F, all other
+ * bytes >= 0xA0 are identical with ISO-8859-1. Unassigned bytes
+ * are mapped to 0 and replaced with '?'.
+ */
+static const uint16_t cp1252[32] =
+{
+  0x20AC, 0,      0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021,
+  0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0,      0x017D, 0,
+  0,      0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+  0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0,      0x017E, 0x0178,
+};
+
+enum Charset { UTF8, LATIN1, CP1252 };
+
+/**
+ * A string is UTF-8 if all multibyte sequences are well formed,
+ * otherwise it is Windows-1252 if it uses bytes of 0x80..0x9F, 
+ * which are control characters in ISO-8859-1 and not used there.
+ */
+static Charset detectCharset(const uint8_t *s, size_t len)
+{
+  bool validUtf8 = true, hasC1 = false;
+  for (size_t i = 0; i < len; )
+  {
+    uint8_t n = utf8SeqLen[s[i]];
+    if (s[i] >= 0x80 && s[i] < 0xA0) hasC1 = true;
+    if (validUtf8)
+    {
+      if (n == 0 || i + n > len) validUtf8 = false;
+      else for (uint8_t k = 1; k < n; k++) if ((s[i + k] & 0xC0) != 0x80) { validUtf8 = false; break; }
+    }
+    if (validUtf8) i += n;
+    else i++;
+  }
+  return validUtf8 ? UTF8 : hasC1 ? CP1252 : LATIN1;
+}
+
+
+static inline uint16_t codePoint(uint8_t c, Charset cs)
+{
+  if (c < 0x80) return c;
+  if (cs == CP1252 && c < 0xA0) return cp1252[c - 0x80] ? cp1252[c - 0x80] : '?';
+  return c;
+}
+
+static inline uint8_t utf8Len(uint16_t cp) { return cp < 0x80 ? 1 : cp < 0x800 ? 2 : 3; }
+
+
+/**
+ * Convert the zero terminated string in buf to UTF-8 in place.
+ * The result is truncated at a character boundary to fit into 
+ * size bytes including the terminator. Returns the new length.
+ */
+size_t toUtf8(char *buf, size_t size)
+{
+  uint8_t *s = (uint8_t *)buf;
+  size_t len = strnlen(buf, size - 1);
+  s[len] = '\0';
+  Charset cs = detectCharset(s, len);
+  if (cs == UTF8) return len;
+
+  // count the input characters which fit and the resulting length
+  size_t nIn = 0, nOut = 0;
+  while (nIn < len && nOut + utf8Len(codePoint(s[nIn], cs)) < size)
+  {
+    nOut += utf8Len(codePoint(s[nIn], cs));
+    nIn++;
+  }
+
+  // expand from the end so no byte is overwritten before it is read
+  uint8_t *dst = s + nOut;
+  *dst = '\0';
+  while (nIn > 0)
+  {
+    uint16_t cp = codePoint(s[--nIn], cs);
+    switch (utf8Len(cp))
+    {
+      case 1: *--dst = cp; break;
+      case 2: *--dst = 0x80 | (cp & 0x3F); *--dst = 0xC0 | (cp >> 6); break;
+      case 3: *--dst = 0x80 | (cp & 0x3F); *--dst = 0x80 | ((cp >> 6) & 0x3F); *--dst = 0xE0 | (cp >> 12); break;
+    }
+  }
+  return nOut;
+}
+
+
+/**
+ * Copy a metadata string into a bounded static buffer and convert 
+ * it to UTF-8. The result is valid until the next call.
+ */
+const char *metadataToUtf8(const char *info)
+{
+  static char buf[METADATA_MAX];
+  strncpy(buf, info, sizeof(buf) - 1);
+  buf[sizeof(buf) - 1] = '\0';
+  toUtf8(buf, sizeof(buf));
+  return buf;
+}
@@ -0,0 +1,26 @@
+#include <Arduino.h>
+#include "clock.h"
+
+#ifdef VIRTUAL_CLOCK
+#include <atomic>
+
+#define EPOCH_START   1735689600   // 2025-01-01 00:00:00 UTC
+
+static std::atomic<uint64_t> msNow;
+
+uint32_t clockMs()   { return (uint32_t)msNow; }
+time_t clockTime()   { return EPOCH_START + msNow / 1000; }
+
+void clockAdvance(uint32_t ms) { msNow += ms; }
+
+/**
+ * Sleeping moves the time on, the other 
+ * threads of a test still get the CPU
+ */
+void clockSleep(uint32_t ms)
+{
+  clockAdvance(ms);
+  delay(0);
+}
+
+#endif
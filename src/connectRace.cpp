@@ -0,0 +1,143 @@
+#include <Arduino.h>
+#include <WiFi.h>
+#include <lwip/sockets.h>
+#include <freertos/semphr.h>
+#include "metrics.h"
+#include "clock.h"
+#include "dns.h"
+#include "connectRace.h"
+
+#define RACE_MAX_ADDRS   4      // addresses raced per host
+#define RACE_STAGGER_MS  250    // head start of each address over the next
+#define RACE_TIMEOUT_MS  3000
+#define DNS_TIMEOUT_MS   1000
+#define WINNER_CACHE     8      // hosts whose winning address is remembered
+
+static struct { char host[64]; uint32_t ip; } winners[WINNER_CACHE];
+static uint8_t nextWinner = 0;
+static SemaphoreHandle_t raceMutex = xSemaphoreCreateMutex();
+
+
+/**
+ * lwIP resolves a name to one address only, so ask the DNS server 
+ * directly and collect up to max A records of the answer
+ */
+static uint8_t resolveAll(const char *host, uint32_t *addrs, uint8_t max)
+{
+  uint8_t msg[DNS_MSG_SIZE];
+  uint16_t id = esp_random();
+  size_t n = dnsBuildQuery(host, id, msg, sizeof(msg));
+  if (n == 0) return 0;
+
+  WiFiUDP udp;
+  udp.begin(0);
+  udp.beginPacket(WiFi.dnsIP(), 53);
+  udp.write(msg, n);
+  udp.endPacket();
+
+  int found = -1;
+  uint32_t msStart = clockMs();
+  while (found < 0 && clockMs() - msStart < DNS_TIMEOUT_MS)
+  {
+    int len = udp.parsePacket() > 0 ? udp.read(msg, sizeof(msg)) : 0;
+    if (len > 0) found = dnsParseAnswer(msg, len, id, addrs, max);
+    else clockSleep(5);
+  }
+  udp.stop();
+  return std::max(found, 0);
+}
+
+
+static uint32_t rememberedWinner(const char *host)
+{
+  for (auto &w : winners) if (strcmp(w.host, host) == 0) return w.ip;
+  return 0;
+}
+
+
+static void rememberWinner(const char *host, uint32_t ip)
+{
+  for (auto &w : winners) if (strcmp(w.host, host) == 0) { w.ip = ip; return; }
+  strncpy(winners[nextWinner].host, host, sizeof(winners[0].host) - 1);
+  winners[nextWinner].ip = ip;
+  nextWinner = (nextWinner + 1) % WINNER_CACHE;
+}
+
+
+/**
+ * Race non-blocking connects to the addresses of host, each started 
+ * RACE_STAGGER_MS after the previous one. The first to connect wins, 
+ * the others are closed. The winner of the last race is tried first.
+ * The race ends early once all addresses have failed.
+ * Returns the connected socket in blocking mode, or -1 on failure.
+ */
+int raceConnect(const char *host, uint16_t port, IPAddress &winner)
+{
+  uint32_t addrs[RACE_MAX_ADDRS];
+  int      fds[RACE_MAX_ADDRS];
+  uint8_t  n = resolveAll(host, addrs, RACE_MAX_ADDRS);
+  if (n == 0)
+  {
+    IPAddress ip;
+    if (!WiFi.hostByName(host, ip)) return -1;
+    addrs[0] = ip;
+    n = 1;
+  }
+
+  // move the remembered winner to the front
+  xSemaphoreTake(raceMutex, portMAX_DELAY);
+  uint32_t last = rememberedWinner(host);
+  xSemaphoreGive(raceMutex);
+  for (uint8_t i = 1; i < n; i++) if (addrs[i] == last) std::swap(addrs[0], addrs[i]);
+
+  uint8_t started = 0, failed = 0;
+  int won = -1;
+  uint32_t msStart = clockMs();
+  while (won < 0 && failed < n && clockMs() - msStart < RACE_TIMEOUT_MS)
+  {
+    // start the next contender when its stagger is due
+    if (started < n && clockMs() - msStart >= started * RACE_STAGGER_MS)
+    {
+      struct sockaddr_in sa = {};
+      sa.sin_family = AF_INET;
+      sa.sin_port = htons(port);
+      sa.sin_addr.s_addr = addrs[started];
+      fds[started] = socket(AF_INET, SOCK_STREAM, 0);
+      if (fds[started] >= 0)
+      {
+        fcntl(fds[started], F_SETFL, O_NONBLOCK);
+        connect(fds[started], (struct sockaddr *)&sa, sizeof(sa));
+      }
+      else failed++;
+      started++;
+    }
+
+    fd_set wset;
+    FD_ZERO(&wset);
+    int maxFd = -1;
+    for (uint8_t i = 0; i < started; i++) if (fds[i] >= 0) { FD_SET(fds[i], &wset); maxFd = std::max(maxFd, fds[i]); }
+    struct timeval tv = { 0, 20 * 1000 };
+    if (maxFd < 0) { clockSleep(20); continue; }   // the next contender is not due yet
+    if (select(maxFd + 1, NULL, &wset, NULL, &tv) <= 0) continue;
+
+    for (uint8_t i = 0; i < started && won < 0; i++)
+    {
+      if (fds[i] < 0 || !FD_ISSET(fds[i], &wset)) continue;
+      int err = 0;
+      socklen_t len = sizeof(err);
+      getsockopt(fds[i], SOL_SOCKET, SO_ERROR, &err, &len);
+      if (err == 0) won = i;
+      else { close(fds[i]); fds[i] = -1; failed++; }   // refused, let the others run
+    }
+  }
+  for (uint8_t i = 0; i < started; i++) if (fds[i] >= 0 && i != won) close(fds[i]);
+
+  if (won < 0) return -1;
+  if (won > 0) metricAdd(RACE_FALLBACKS);
+  fcntl(fds[won], F_SETFL, fcntl(fds[won], F_GETFL, 0) & ~O_NONBLOCK);
+  winner = IPAddress(addrs[won]);
+  xSemaphoreTake(raceMutex, portMAX_DELAY);
+  rememberWinner(host, addrs[won]);
+  xSemaphoreGive(raceMutex);
+  return fds[won];
+}
@@ -0,0 +1,246 @@
+#include <Arduino.h>
+#include "display.h"
+#include "metrics.h"
+#include "dsp.h"
+
+#define DISPLAY_SDA         GPIO_NUM_21
+#define DISPLAY_SCL         GPIO_NUM_22
+#define DISPLAY_TASK_PRIORITY (tskIDLE_PRIORITY + 1)
+#define FRAME_MS            100
+#define GLYPH_WIDTH         6     // 5 pixels and a space
+#define TEXT_COLS           (DISPLAY_WIDTH / GLYPH_WIDTH)
+#define METER_DECAY         4     // columns per frame
+
+// classic 5x7 font for ASCII 0x20..0x7E, one byte per column
+static const uint8_t font[][5] PROGMEM =
+{
+  {0x00,0x00,0x00,0x00,0x00}, {0x00,0x00,0x5F,0x00,0x00}, {0x00,0x07,0x00,0x07,0x00}, {0x14,0x7F,0x14,0x7F,0x14},
+  {0x24,0x2A,0x7F,0x2A,0x12}, {0x23,0x13,0x08,0x64,0x62}, {0x36,0x49,0x55,0x22,0x50}, {0x00,0x05,0x03,0x00,0x00},
+  {0x00,0x1C,0x22,0x41,0x00}, {0x00,0x41,0x22,0x1C,0x00}, {0x08,0x2A,0x1C,0x2A,0x08}, {0x08,0x08,0x3E,0x08,0x08},
+  {0x00,0x50,0x30,0x00,0x00}, {0x08,0x08,0x08,0x08,0x08}, {0x00,0x60,0x60,0x00,0x00}, {0x20,0x10,0x08,0x04,0x02},
+  {0x3E,0x51,0x49,0x45,0x3E}, {0x00,0x42,0x7F,0x40,0x00}, {0x42,0x61,0x51,0x49,0x46}, {0x21,0x41,0x45,0x4B,0x31},
+  {0x18,0x14,0x12,0x7F,0x10}, {0x27,0x45,0x45,0x45,0x39}, {0x3C,0x4A,0x49,0x49,0x30}, {0x01,0x71,0x09,0x05,0x03},
+  {0x36,0x49,0x49,0x49,0x36}, {0x06,0x49,0x49,0x29,0x1E}, {0x00,0x36,0x36,0x00,0x00}, {0x00,0x56,0x36,0x00,0x00},
+  {0x08,0x14,0x22,0x41,0x00}, {0x14,0x14,0x14,0x14,0x14}, {0x00,0x41,0x22,0x14,0x08}, {0x02,0x01,0x51,0x09,0x06},
+  {0x32,0x49,0x79,0x41,0x3E}, {0x7E,0x11,0x11,0x11,0x7E}, {0x7F,0x49,0x49,0x49,0x36}, {0x3E,0x41,0x41,0x41,0x22},
+  {0x7F,0x41,0x41,0x22,0x1C}, {0x7F,0x49,0x49,0x49,0x41}, {0x7F,0x09,0x09,0x09,0x01}, {0x3E,0x41,0x49,0x49,0x7A},
+  {0x7F,0x08,0x08,0x08,0x7F}, {0x00,0x41,0x7F,0x41,0x00}, {0x20,0x40,0x41,0x3F,0x01}, {0x7F,0x08,0x14,0x22,0x41},
+  {0x7F,0x40,0x40,0x40,0x40}, {0x7F,0x02,0x0C,0x02,0x7F}, {0x7F,0x04,0x08,0x10,0x7F}, {0x3E,0x41,0x41,0x41,0x3E},
+  {0x7F,0x09,0x09,0x09,0x06}, {0x3E,0x41,0x51,0x21,0x5E}, {0x7F,0x09,0x19,0x29,0x46}, {0x46,0x49,0x49,0x49,0x31},
+  {0x01,0x01,0x7F,0x01,0x01}, {0x3F,0x40,0x40,0x40,0x3F}, {0x1F,0x20,0x40,0x20,0x1F}, {0x3F,0x40,0x38,0x40,0x3F},
+  {0x63,0x14,0x08,0x14,0x63}, {0x07,0x08,0x70,0x08,0x07}, {0x61,0x51,0x49,0x45,0x43}, {0x00,0x7F,0x41,0x41,0x00},
+  {0x02,0x04,0x08,0x10,0x20}, {0x00,0x41,0x41,0x7F,0x00}, {0x04,0x02,0x01,0x02,0x04}, {0x40,0x40,0x40,0x40,0x40},
+  {0x00,0x01,0x02,0x04,0x00}, {0x20,0x54,0x54,0x54,0x78}, {0x7F,0x48,0x44,0x44,0x38}, {0x38,0x44,0x44,0x44,0x20},
+  {0x38,0x44,0x44,0x48,0x7F}, {0x38,0x54,0x54,0x54,0x18}, {0x08,0x7E,0x09,0x01,0x02}, {0x0C,0x52,0x52,0x52,0x3E},
+  {0x7F,0x08,0x04,0x04,0x78}, {0x00,0x44,0x7D,0x40,0x00}, {0x20,0x40,0x44,0x3D,0x00}, {0x7F,0x10,0x28,0x44,0x00},
+  {0x00,0x41,0x7F,0x40,0x00}, {0x7C,0x04,0x18,0x04,0x78}, {0x7C,0x08,0x04,0x04,0x78}, {0x38,0x44,0x44,0x44,0x38},
+  {0x7C,0x14,0x14,0x14,0x08}, {0x08,0x14,0x14,0x18,0x7C}, {0x7C,0x08,0x04,0x04,0x08}, {0x48,0x54,0x54,0x54,0x20},
+  {0x04,0x3F,0x44,0x40,0x20}, {0x3C,0x40,0x40,0x20,0x7C}, {0x1C,0x20,0x40,0x20,0x1C}, {0x3C,0x40,0x30,0x40,0x3C},
+  {0x44,0x28,0x10,0x28,0x44}, {0x0C,0x50,0x50,0x50,0x3C}, {0x44,0x64,0x54,0x4C,0x44}, {0x00,0x08,0x36,0x41,0x00},
+  {0x00,0x00,0x7F,0x00,0x00}, {0x00,0x41,0x36,0x08,0x00}, {0x08,0x04,0x08,0x10,0x08},
+};
+
+// page layout
+#define PAGE_STATION   0
+#define PAGE_TITLE     2     // and the next page
+#define PAGE_VOLUME    5
+#define PAGE_METER_L   6
+#define PAGE_METER_R   7
+
+static uint8_t fb[DISPLAY_PAGES][DISPLAY_WIDTH];
+static struct { int16_t col0, col1; } dirty[DISPLAY_PAGES];
+
+static portMUX_TYPE textMux = portMUX_INITIALIZER_UNLOCKED;
+static char station[TEXT_COLS + 1];
+static char title[2 * TEXT_COLS + 1];
+static char volume[TEXT_COLS + 1];
+static volatile bool textChanged = true;
+
+static Ssd1306Display ssd1306(DISPLAY_SDA, DISPLAY_SCL);
+static VirtualDisplay virtualDisplay;
+static uint32_t framesTotal;
+static DisplayBackend *backend = &virtualDisplay;
+
+
+/**
+ * Write a byte to the framebuffer, a region only gets
+ * dirty if its pixels actually change
+ */
+static void setByte(uint8_t page, uint8_t col, uint8_t value)
+{
+  if (fb[page][col] == value) return;
+  fb[page][col] = value;
+  if (dirty[page].col0 < 0 || col < dirty[page].col0) dirty[page].col0 = col;
+  if (col > dirty[page].col1) dirty[page].col1 = col;
+}
+
+
+/**
+ * Draw a line of text and blank the rest of the page. Characters
+ * outside of ASCII are shown as '?', UTF-8 sequences as one of them.
+ */
+static void drawText(uint8_t page, const char *txt)
+{
+  uint8_t col = 0;
+  for (const uint8_t *p = (const uint8_t *)txt; *p && col + GLYPH_WIDTH <= DISPLAY_WIDTH; p++)
+  {
+    if ((*p & 0xC0) == 0x80) continue;   // UTF-8 continuation
+    uint8_t c = (*p >= 0x20 && *p < 0x7F) ? *p : '?';
+    for (uint8_t i = 0; i < 5; i++) setByte(page, col++, pgm_read_byte(&font[c - 0x20][i]));
+    setByte(page, col++, 0);
+  }
+  while (col < DISPLAY_WIDTH) setByte(page, col++, 0);
+}
+
+
+/**
+ * Draw a level meter, the bar grows by 8 columns per 6 dB
+ * and falls back slowly
+ */
+static void drawMeter(uint8_t page, uint16_t peak, int16_t &bar)
+{
+  int16_t cols = peak ? (32 - __builtin_clz(peak)) * 8 : 0;
+  bar = std::max<int16_t>(cols, bar - METER_DECAY);
+  for (uint8_t col = 0; col < DISPLAY_WIDTH; col++) setByte(page, col, col < bar ? 0x3C : 0x00);
+}
+
+
+/**
+ * Redraw the text, if it has changed, and the meters
+ */
+static void render()
+{
+  if (textChanged)
+  {
+    char txt[3][2 * TEXT_COLS + 1];
+    portENTER_CRITICAL(&textMux);
+    textChanged = false;
+    strcpy(txt[0], station);
+    strcpy(txt[1], title);
+    strcpy(txt[2], volume);
+    portEXIT_CRITICAL(&textMux);
+
+    drawText(PAGE_STATION, txt[0]);
+    // wrap the title at the end of the first line
+    size_t n = 0;
+    for (size_t chars = 0; txt[1][n] && chars < TEXT_COLS; n++) if ((txt[1][n] & 0xC0) != 0x80) chars++;
+    while ((txt[1][n] & 0xC0) == 0x80) n++;
+    drawText(PAGE_TITLE + 1, txt[1] + n);
+    txt[1][n] = '\0';
+    drawText(PAGE_TITLE, txt[1]);
+    drawText(PAGE_VOLUME, txt[2]);
+  }
+
+  static int16_t barL, barR;
+  uint16_t left, right;
+  dspPeaks(left, right);
+  drawMeter(PAGE_METER_L, left, barL);
+  drawMeter(PAGE_METER_R, right, barR);
+}
+
+
+/**
+ * Send the dirty regions to the display
+ */
+static uint32_t flush()
+{
+  uint32_t bytes = 0;
+  for (uint8_t page = 0; page < DISPLAY_PAGES; page++)
+  {
+    if (dirty[page].col0 < 0) continue;
+    const uint8_t *data = &fb[page][dirty[page].col0];
+    if (backend != &virtualDisplay) backend->write(page, dirty[page].col0, dirty[page].col1, data);
+    virtualDisplay.write(page, dirty[page].col0, dirty[page].col1, data);
+    bytes += dirty[page].col1 - dirty[page].col0 + 1;
+    dirty[page].col0 = dirty[page].col1 = -1;
+  }
+  return bytes;
+}
+
+
+/**
+ * Render and flush one frame outside of the display task, 
+ * e.g. in the host test. Returns the bytes sent.
+ */
+uint32_t displayFrame()
+{
+  render();
+  framesTotal++;
+  return flush();
+}
+
+
+/**
+ * Render and flush a frame every 100 ms below the priority of
+ * the audio task, report the cost of it once per second
+ */
+static void displayTask(void *param)
+{
+  uint32_t bytes = 0, usRender = 0, usFlush = 0, frames = 0;
+  TickType_t wake = xTaskGetTickCount();
+  while (true)
+  {
+    uint32_t us = micros();
+    render();
+    usRender += micros() - us;
+    us = micros();
+    bytes += flush();
+    usFlush += micros() - us;
+    framesTotal++;
+
+    if (++frames == 1000 / FRAME_MS)
+    {
+      metricSet(DISPLAY_BYTES_PER_S, bytes);
+      metricSet(DISPLAY_RENDER_US, usRender / frames);
+      metricSet(DISPLAY_FLUSH_US, usFlush / frames);
+      bytes = usRender = usFlush = frames = 0;
+    }
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(FRAME_MS));
+  }
+}
+
+
+static void setText(char *dest, size_t len, const char *txt)
+{
+  portENTER_CRITICAL(&textMux);
+  strlcpy(dest, txt, len);
+  textChanged = true;
+  portEXIT_CRITICAL(&textMux);
+}
+
+void displayStation(const char *txt) { setText(station, sizeof(station), txt); }
+void displayTitle(const char *txt)   { setText(title, sizeof(title), txt); }
+
+void displayVolume(uint8_t zone, int vol)
+{
+  char txt[TEXT_COLS + 1];
+  snprintf(txt, sizeof(txt), "Zone %d  Volume %d", zone + 1, vol);
+  setText(volume, sizeof(volume), txt);
+}
+
+
+/**
+ * Print the virtual display, which mirrors the real one, and the bytes it received,
+ * compared to redrawing the full frame each time
+ */
+void showDisplay(const char *txt)
+{
+  Serial.println();
+  virtualDisplay.print(Serial);
+  Serial.printf("%u updates, %u bytes, full redraws would be %u bytes\r\n",
+    virtualDisplay.writes, virtualDisplay.bytes, framesTotal * (uint32_t)sizeof(fb));
+}
+
+
+/**
+ * Use the SSD1306, if one answers on I2C, the virtual
+ * display otherwise, and start the display task
+ */
+void initDisplay()
+{
+  if (ssd1306.begin()) backend = &ssd1306;
+  else log_w("==> No SSD1306 found, using the virtual display");
+  for (auto &d : dirty) d.col0 = d.col1 = -1;
+  memset(fb, 0xFF, sizeof(fb));   // makes the first frame dirty everywhere
+  xTaskCreatePinnedToCore(displayTask, "display", 4096, NULL, DISPLAY_TASK_PRIORITY, NULL, 0);
+}
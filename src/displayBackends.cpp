@@ -0,0 +1,89 @@
+#include <Arduino.h>
+#include <Wire.h>
+#include "display.h"
+
+#define I2C_CLOCK     400000
+#define I2C_CHUNK     64      // data bytes per transmission, fits the Wire buffer
+
+/**
+ * Wake the SSD1306 with horizontal addressing, so a column
+ * range of a page is written with one address window
+ */
+bool Ssd1306Display::begin()
+{
+  static const uint8_t init[] =
+  {
+    0xAE,             // display off
+    0xD5, 0x80,       // clock divider
+    0xA8, 0x3F,       // 64 rows
+    0xD3, 0x00,       // no display offset
+    0x40,             // start line 0
+    0x8D, 0x14,       // charge pump on
+    0x20, 0x00,       // horizontal addressing
+    0xA1, 0xC8,       // flip horizontally and vertically
+    0xDA, 0x12,       // com pins
+    0x81, 0xCF,       // contrast
+    0xD9, 0xF1,       // precharge
+    0xDB, 0x40,       // vcom detect
+    0xA4, 0xA6,       // show RAM, not inverted
+    0xAF              // display on
+  };
+  Wire.begin(sda, scl, I2C_CLOCK);
+  Wire.beginTransmission(address);
+  if (Wire.endTransmission() != 0) return false;
+  command(init, sizeof(init));
+  return true;
+}
+
+
+void Ssd1306Display::command(const uint8_t *cmds, size_t len)
+{
+  Wire.beginTransmission(address);
+  Wire.write(0x00);   // control byte: commands follow
+  Wire.write(cmds, len);
+  Wire.endTransmission();
+}
+
+
+void Ssd1306Display::write(uint8_t page, uint8_t col0, uint8_t col1, const uint8_t *data)
+{
+  const uint8_t window[] = { 0x21, col0, col1, 0x22, page, page };
+  command(window, sizeof(window));
+
+  size_t len = col1 - col0 + 1;
+  for (size_t done = 0; done < len; done += I2C_CHUNK)
+  {
+    Wire.beginTransmission(address);
+    Wire.write(0x40); // control byte: data follows
+    Wire.write(data + done, std::min<size_t>(I2C_CHUNK, len - done));
+    Wire.endTransmission();
+  }
+}
+
+
+void VirtualDisplay::write(uint8_t page, uint8_t col0, uint8_t col1, const uint8_t *data)
+{
+  memcpy(&ram[page][col0], data, col1 - col0 + 1);
+  bytes += col1 - col0 + 1;
+  writes++;
+}
+
+
+/**
+ * Print the pixels with two rows per character line
+ */
+void VirtualDisplay::print(Print &out)
+{
+  for (uint8_t y = 0; y < DISPLAY_PAGES * 8; y += 2)
+  {
+    char line[DISPLAY_WIDTH + 3];
+    for (uint8_t x = 0; x < DISPLAY_WIDTH; x++)
+    {
+      bool upper = ram[y / 8][x] & (1 << (y % 8));
+      bool lower = ram[y / 8][x] & (2 << (y % 8));
+      line[x] = upper ? (lower ? '8' : '"') : (lower ? '.' : ' ');
+    }
+    strcpy(line + DISPLAY_WIDTH, "\r\n");
+    out.print(line);
+  }
+}
@@ -0,0 +1,87 @@
+#include <Arduino.h>
+#include "dns.h"
+
+#define DNS_TYPE_A   1
+#define DNS_CLASS_IN 1
+
+
+/**
+ * Build a query for the A records of host with recursion desired.
+ * Returns its length, 0 if host is not a valid name.
+ */
+size_t dnsBuildQuery(const char *host, uint16_t id, uint8_t *msg, size_t size)
+{
+  const uint8_t header[] = { (uint8_t)(id >> 8), (uint8_t)id, 0x01, 0x00, 0, 1, 0, 0, 0, 0, 0, 0 };
+  if (size < sizeof(header)) return 0;
+  memcpy(msg, header, sizeof(header));
+  size_t n = sizeof(header);
+  for (const char *label = host; *label; )
+  {
+    size_t len = strcspn(label, ".");
+    if (len == 0 || len > 63 || n + len + 6 > size) return 0;
+    msg[n++] = len;
+    memcpy(msg + n, label, len);
+    n += len;
+    label += len;
+    if (*label == '.') label++;
+  }
+  const uint8_t question[] = { 0, 0, DNS_TYPE_A, 0, DNS_CLASS_IN };  // root, type, class
+  memcpy(msg + n, question, sizeof(question));
+  return n + sizeof(question);
+}
+
+
+/**
+ * Skip a name, labels which end with the root or with a pointer to 
+ * a name elsewhere in the message. Returns the position after it, 
+ * 0 if the name is malformed or runs past the message.
+ */
+static size_t skipName(const uint8_t *msg, size_t len, size_t p)
+{
+  while (p < len)
+  {
+    uint8_t b = msg[p];
+    if (b == 0)             return p + 1;
+    if ((b & 0xC0) == 0xC0) return p + 2 <= len ? p + 2 : 0;
+    if (b & 0xC0)           return 0;   // reserved label types
+    p += b + 1;
+  }
+  return 0;
+}
+
+
+/**
+ * Collect up to max A records from the response to the query with id, 
+ * in network byte order. Any other answer, e.g. a CNAME, is skipped.
+ * Returns the number of addresses, -1 if msg is not that response.
+ */
+int dnsParseAnswer(const uint8_t *msg, size_t len, uint16_t id, uint32_t *addrs, uint8_t max)
+{
+  if (len < 12 || (msg[0] << 8 | msg[1]) != id || !(msg[2] & 0x80)) return -1;
+  if ((msg[3] & 0x0F) != 0) return 0;   // the server reports an error
+  uint16_t nQuestions = msg[4] << 8 | msg[5];
+  uint16_t nAnswers   = msg[6] << 8 | msg[7];
+
+  size_t p = 12;
+  for (uint16_t i = 0; i < nQuestions; i++)
+  {
+    p = skipName(msg, len, p);
+    if (p == 0 || p + 4 > len) return 0;
+    p += 4;   // type and class
+  }
+
+  int found = 0;
+  for (uint16_t i = 0; i < nAnswers && found < max; i++)
+  {
+    p = skipName(msg, len, p);
+    if (p == 0 || p + 10 > len) break;
+    uint16_t type  = msg[p] << 8 | msg[p + 1];
+    uint16_t cls   = msg[p + 2] << 8 | msg[p + 3];
+    uint16_t rdLen = msg[p + 8] << 8 | msg[p + 9];
+    p += 10;
+    if (p + rdLen > len) break;
+    if (type == DNS_TYPE_A && cls == DNS_CLASS_IN && rdLen == 4) memcpy(&addrs[found++], msg + p, 4);
+    p += rdLen;
+  }
+  return found;
+}
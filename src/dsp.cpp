@@ -0,0 +1,210 @@
+#include <Arduino.h>
+#include "metrics.h"
+#include "audioTask.h"
+#include "dsp.h"
+
+#define CONCEAL_FRAMES 576   // one granule, kept to bridge a gap
+#define UNITY_GAIN     65536 // gain in Q16
+
+/**
+ * Concealment state of a zone: a gap reported by its decoder and 
+ * the end of the last block it played, before the volume stage
+ */
+struct Conceal
+{
+  volatile bool     pending;
+  volatile uint32_t usErrorAt;
+  int16_t  last[CONCEAL_FRAMES * 2];
+  uint16_t lastFrames;
+  uint8_t  lastChannels;
+};
+
+static Conceal conceal[NBR_ZONES];
+static volatile int32_t  gainQ16[NBR_ZONES] = { UNITY_GAIN, UNITY_GAIN };
+static volatile bool     ditherOn       = true;
+static uint32_t          ditherState    = 1;
+
+
+/**
+ * The decoder reports a corrupt frame through audio_info(), which runs
+ * within the loop() of its zone. It skips the frame and scans for the
+ * next syncword, so the next block of PCM of that zone follows a gap.
+ * Count the frame and remember when it happened.
+ */
+void dspOnInfo(const char *info)
+{
+  if (strstr(info, "decode error") || strstr(info, "syncword"))
+  {
+    Conceal &z = conceal[currentZone()];
+    metricAdd(CONCEALED_FRAMES);
+    if (!z.pending) z.usErrorAt = micros();
+    z.pending = true;
+  }
+}
+
+
+/**
+ * Cross-fade the first block after a gap from the last granule before 
+ * it. The granule is played backwards from where the output stopped, so 
+ * it joins without a step, and fades out while the new block fades in.
+ * Without a granule of the same layout the block is only faded in.
+ */
+static void concealGap(Conceal &z, int16_t *buf, uint16_t frames, uint8_t channels)
+{
+  bool repeat = z.lastChannels == channels && z.lastFrames > 0;
+  uint16_t n = std::min<uint16_t>(frames, repeat ? z.lastFrames : CONCEAL_FRAMES);
+  for (uint16_t i = 0; i < n; i++)
+  {
+    const int16_t *old = z.last + (z.lastFrames - 1 - i) * channels;
+    for (uint8_t c = 0; c < channels; c++)
+    {
+      int32_t s = (int32_t)buf[i * channels + c] * i + (repeat ? (int32_t)old[c] * (n - i) : 0);
+      buf[i * channels + c] = s / n;
+    }
+  }
+}
+
+
+/**
+ * Keep the end of the block, the granule a gap is bridged with
+ */
+static void keepLast(Conceal &z, const int16_t *buf, uint16_t frames, uint8_t channels)
+{
+  if (channels > 2) { z.lastFrames = 0; return; }
+  z.lastFrames   = std::min<uint16_t>(frames, CONCEAL_FRAMES);
+  z.lastChannels = channels;
+  memcpy(z.last, buf + (frames - z.lastFrames) * channels, z.lastFrames * channels * sizeof(int16_t));
+}
+
+
+static void reportResync(Conceal &z)
+{
+  uint32_t msResync = (micros() - z.usErrorAt) / 1000;
+  metricSet(RESYNC_MS_LAST, msResync);
+  if ((int32_t)msResync > metricGet(RESYNC_MS_MAX)) metricSet(RESYNC_MS_MAX, msResync);
+}
+
+
+/**
+ * Set the digital volume of a zone with the square law curve of the 
+ * audio library. The library itself stays at full volume, so the 
+ * samples reach this stage with all 16 bits of resolution.
+ */
+void setDigitalVolume(uint8_t zone, uint8_t vol, uint8_t maxVol)
+{
+  if (zone < NBR_ZONES) gainQ16[zone] = (uint64_t)UNITY_GAIN * vol * vol / (maxVol * maxVol);
+}
+
+void setDither(bool on) { ditherOn = on; }
+bool ditherEnabled()    { return ditherOn; }
+
+
+/**
+ * Triangular dither of +-1 LSB of the 16 bit output in Q16, 
+ * the sum of two uniform values from a xorshift generator
+ */
+static inline int32_t tpdf()
+{
+  ditherState ^= ditherState << 13;
+  ditherState ^= ditherState >> 17;
+  ditherState ^= ditherState << 5;
+  return (int32_t)(ditherState & 0xFFFF) - (int32_t)(ditherState >> 16);
+}
+
+
+/**
+ * Apply the Q16 gain to the 16 bit samples and round back to 16 bits, 
+ * with dither the rounding error turns into a faint, even noise 
+ * instead of the grainy distortion of quiet passages
+ */
+static void applyVolume(int16_t *buf, uint16_t frames, uint8_t channels, bool dither)
+{
+  int32_t gain = gainQ16[currentZone()];
+  if (gain == 0)
+  {
+    memset(buf, 0, (uint32_t)frames * channels * sizeof(int16_t));   // silence, not dither noise
+    return;
+  }
+  for (uint32_t i = 0; i < (uint32_t)frames * channels; i++)
+  {
+    int32_t acc = buf[i] * gain + (dither ? tpdf() : 0) + (1 << 15);
+    buf[i] = constrain(acc >> 16, -32768, 32767);
+  }
+}
+
+
+/**
+ * Peak levels of zone 1 for the level meters
+ */
+static volatile uint16_t peakL, peakR;
+
+static void measurePeaks(const int16_t *buf, uint16_t frames, uint8_t channels)
+{
+  uint16_t l = peakL, r = peakR;
+  for (uint16_t i = 0; i < frames; i++)
+  {
+    l = std::max<uint16_t>(l, abs(buf[i * channels]));
+    r = std::max<uint16_t>(r, abs(buf[i * channels + channels - 1]));
+  }
+  peakL = l;
+  peakR = r;
+}
+
+/**
+ * Return and reset the peak levels since the last call
+ */
+void dspPeaks(uint16_t &left, uint16_t &right)
+{
+  left = peakL;
+  right = peakR;
+  peakL = peakR = 0;
+}
+
+
+/**
+ * Hook of the audio library for the decoded PCM before it is written 
+ * to I2S. The stages are applied in place.
+ */
+void audio_process_i2s(int16_t *outBuff, uint16_t validSamples, uint8_t bitsPerSample, uint8_t channels, bool *continueI2S)
+{
+  *continueI2S = true;
+  if (bitsPerSample != 16 || validSamples == 0) return;
+  Conceal &z = conceal[currentZone()];
+  if (z.pending)
+  {
+    z.pending = false;
+    reportResync(z);
+    concealGap(z, outBuff, validSamples, channels);
+  }
+  keepLast(z, outBuff, validSamples, channels);
+  if (gainQ16[currentZone()] != UNITY_GAIN) applyVolume(outBuff, validSamples, channels, ditherOn);
+  if (currentZone() == 0) measurePeaks(outBuff, validSamples, channels);
+}
+
+
+/**
+ * Cost of each DSP stage for one MP3 frame of stereo samples
+ */
+void benchmarkDsp(void (*report)(const char *name, uint32_t value, const char *unit))
+{
+  static const struct { const char *name; void (*fn)(int16_t *, uint16_t, uint8_t); } stages[] =
+  {
+    { "dsp gap conceal",     [](int16_t *b, uint16_t f, uint8_t c) { static Conceal z; keepLast(z, b, f, c); concealGap(z, b, f, c); } },
+    { "dsp volume",          [](int16_t *b, uint16_t f, uint8_t c) { applyVolume(b, f, c, false); } },
+    { "dsp volume + dither", [](int16_t *b, uint16_t f, uint8_t c) { applyVolume(b, f, c, true); } },
+    { "dsp level meter",     [](int16_t *b, uint16_t f, uint8_t c) { measurePeaks(b, f, c); } },
+  };
+  const uint16_t frames = 1152;
+  const int runs = 100;
+  int16_t *buf = (int16_t *)malloc(frames * 2 * sizeof(int16_t));
+  if (!buf) return;
+  for (uint16_t i = 0; i < frames * 2; i++) buf[i] = esp_random();
+
+  for (auto &stage : stages)
+  {
+    uint32_t usStart = micros();
+    for (int r = 0; r < runs; r++) stage.fn(buf, frames, 2);
+    report(stage.name, (uint64_t)(micros() - usStart) * 1000 / runs, "ns/mp3 frame");
+  }
+  free(buf);
+}
@@ -0,0 +1,161 @@
+#include <Arduino.h>
+#include <SPIFFS.h>
+#include <LittleFS.h>
+#include "readAheadFS.h"
+#include "fileSystems.h"
+
+// Both file systems live side by side, see partitions.csv
+#define LITTLEFS_BASEPATH  "/littlefs"
+#define LITTLEFS_PARTITION "littlefs"
+
+ReadAheadFS spiffsRA(SPIFFS);
+ReadAheadFS littlefsRA(LittleFS);
+
+// Fixtures for the file system benchmark, the stereotest file is uploaded
+// with the SPIFFS image, the larger ones are generated on first use
+static const char fixtureStereo[] = "/stereotest440-445.mp3";
+static const struct { const char *path; size_t size; } generatedFixtures[] =
+{
+  { "/bench64k.bin",   64 * 1024 },
+  { "/bench128k.bin", 128 * 1024 },
+};
+
+
+/**
+ * Copy a file from one file system to another
+ */
+static bool copyFile(fs::FS &from, fs::FS &to, const char *path)
+{
+  uint8_t buf[1024];
+  File src = from.open(path, FILE_READ);
+  if (!src) return false;
+  File dst = to.open(path, FILE_WRITE);
+  if (!dst) return false;
+  size_t n;
+  while ((n = src.read(buf, sizeof(buf))) > 0) dst.write(buf, n);
+  return dst.size() == src.size();
+}
+
+
+/**
+ * Write a file of the given size with pseudo random content unless
+ * it already exists with the right size
+ */
+static bool makeFixture(fs::FS &fs, const char *path, size_t size)
+{
+  if (fs.exists(path))
+  {
+    File f = fs.open(path, FILE_READ);
+    if (f && f.size() == size) return true;
+  }
+  File f = fs.open(path, FILE_WRITE);
+  if (!f) return false;
+  uint32_t buf[256];
+  for (size_t written = 0; written < size; written += sizeof(buf))
+  {
+    for (auto &w : buf) w = esp_random();
+    if (f.write((uint8_t *)buf, std::min(sizeof(buf), size - written)) == 0) return false;
+  }
+  return true;
+}
+
+
+/**
+ * Mount SPIFFS and LittleFS. The filesystem image is uploaded
+ * into SPIFFS only, so the stereotest file is mirrored into 
+ * LittleFS when it is missing there.
+ */
+void initFileSystems()
+{
+  if (! SPIFFS.begin()) log_e("==> SPIFFS mount failed");
+  if (! LittleFS.begin(true, LITTLEFS_BASEPATH, 5, LITTLEFS_PARTITION))
+  {
+    log_e("==> LittleFS mount failed");
+    return;
+  }
+  if (! LittleFS.exists(fixtureStereo) && SPIFFS.exists(fixtureStereo))
+  {
+    if (! copyFile(SPIFFS, LittleFS, fixtureStereo)) log_e("==> Copying %s to LittleFS failed", fixtureStereo);
+  }
+}
+
+
+/**
+ * Read a whole file with the irregular read sizes the audio 
+ * library typically uses and measure duration and worst 
+ * latency of a single read
+ */
+static bool measureRead(fs::FS &fs, const char *path, uint32_t &bytes, uint32_t &usTotal, uint32_t &usMaxRead)
+{
+  static const size_t readSizes[] = { 417, 1044, 1600, 313, 2048 };
+  static uint8_t buf[2048];
+  uint32_t i = 0;
+
+  bytes = usMaxRead = 0;
+  File f = fs.open(path, FILE_READ);
+  if (!f) return false;
+  uint32_t usStart = micros();
+  while (true)
+  {
+    uint32_t usRead = micros();
+    size_t n = f.read(buf, readSizes[i++ % 5]);
+    usRead = micros() - usRead;
+    if (n == 0) break;
+    if (usRead > usMaxRead) usMaxRead = usRead;
+    bytes += n;
+  }
+  usTotal = micros() - usStart;
+  return true;
+}
+
+
+/**
+ * Read throughput in KB/s of a file, 0 if it does not exist
+ */
+uint32_t readThroughput(fs::FS &fs, const char *path)
+{
+  uint32_t bytes, usTotal, usMaxRead;
+  if (!measureRead(fs, path, bytes, usTotal, usMaxRead) || usTotal == 0) return 0;
+  return (uint64_t)bytes * 1000000 / 1024 / usTotal;
+}
+
+
+static void benchmarkRead(const char *fsName, fs::FS &fs, const char *path)
+{
+  uint32_t bytes, usTotal, usMaxRead;
+  if (!measureRead(fs, path, bytes, usTotal, usMaxRead)) 
+  {
+    Serial.printf("%-18s %-22s not found\r\n", fsName, path);
+    return;
+  }
+  Serial.printf("%-18s %-22s %7u bytes %6u KB/s  max read %6u us\r\n", 
+                fsName, path, bytes, usTotal ? (uint32_t)((uint64_t)bytes * 1000000 / 1024 / usTotal) : 0, usMaxRead);
+}
+
+
+/**
+ * Compare the read throughput of SPIFFS and LittleFS,
+ * each with and without read-ahead
+ */
+void benchmarkFileSystems(const char* txt)
+{
+  struct { const char *name; fs::FS &fs; } candidates[] =
+  {
+    { "SPIFFS",            SPIFFS },
+    { "SPIFFS+readahead",  spiffsRA },
+    { "LittleFS",          LittleFS },
+    { "LittleFS+readahead",littlefsRA },
+  };
+
+  Serial.printf("\r\nFile system benchmark\r\n---------------------\r\n");
+  for (auto &fixture : generatedFixtures)
+  {
+    if (! makeFixture(SPIFFS, fixture.path, fixture.size))   log_e("==> No space for %s in SPIFFS", fixture.path);
+    if (! makeFixture(LittleFS, fixture.path, fixture.size)) log_e("==> No space for %s in LittleFS", fixture.path);
+  }
+  for (auto &c : candidates)
+  {
+    benchmarkRead(c.name, c.fs, fixtureStereo);
+    for (auto &fixture : generatedFixtures) benchmarkRead(c.name, c.fs, fixture.path);
+  }
+}
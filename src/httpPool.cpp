@@ -0,0 +1,307 @@
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <WiFiClientSecure.h>
+#include <freertos/semphr.h>
+#include <lwip/sockets.h>
+#include <type_traits>
+#include "httpPool.h"
+#include "metrics.h"
+#include "clock.h"
+#include "connectRace.h"
+
+#define HTTP_MAX_REDIRECTS 3
+#define HTTP_FETCH_TIMEOUT 2000  // ms without data which end a small body
+#define TLS_HANDSHAKE_MS   5000
+
+
+/**
+ * A TLS client which runs the handshake over a socket which is connected 
+ * already, the one which won the race, instead of opening its own. The 
+ * pool does not verify certificates, the same as setInsecure().
+ *
+ * It sets the socket, the mbedTLS contexts and the connected flag of 
+ * WiFiClientSecure, which are not part of its interface. platformio.ini 
+ * pins the core, the checks below stop the build if the layout changes.
+ */
+#if ESP_ARDUINO_VERSION_MAJOR != 2
+#error "RacedSecureClient needs the WiFiClientSecure of arduino-esp32 2.x"
+#endif
+static_assert(std::is_same<decltype(sslclient_context::socket), int>::value, "sslclient_context::socket is no longer an int");
+static_assert(std::is_same<decltype(sslclient_context::ssl_ctx), mbedtls_ssl_context>::value, "sslclient_context::ssl_ctx changed");
+static_assert(std::is_same<decltype(sslclient_context::ssl_conf), mbedtls_ssl_config>::value, "sslclient_context::ssl_conf changed");
+static_assert(std::is_same<decltype(sslclient_context::drbg_ctx), mbedtls_ctr_drbg_context>::value, "sslclient_context::drbg_ctx changed");
+static_assert(std::is_same<decltype(sslclient_context::entropy_ctx), mbedtls_entropy_context>::value, "sslclient_context::entropy_ctx changed");
+
+class RacedSecureClient : public WiFiClientSecure
+{
+  static_assert(std::is_same<decltype(sslclient), sslclient_context *>::value, "WiFiClientSecure::sslclient is no longer a plain pointer");
+  static_assert(std::is_same<decltype(_connected), bool>::value, "WiFiClient::_connected changed");
+
+  public:
+    bool adopt(int fd, const char *host)
+    {
+      stop();
+      sslclient->socket = fd;   // closed by stop() from now on
+      fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+      _connected = handshake(host) == 0;
+      if (!_connected) stop();
+      return _connected;
+    }
+
+  private:
+    int handshake(const char *host)
+    {
+      mbedtls_ssl_context *ssl = &sslclient->ssl_ctx;
+      mbedtls_ssl_config *conf = &sslclient->ssl_conf;
+      mbedtls_entropy_init(&sslclient->entropy_ctx);
+      int ret = mbedtls_ctr_drbg_seed(&sslclient->drbg_ctx, mbedtls_entropy_func, &sslclient->entropy_ctx, nullptr, 0);
+      if (ret == 0) ret = mbedtls_ssl_config_defaults(conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+      if (ret != 0) return ret;
+      mbedtls_ssl_conf_authmode(conf, MBEDTLS_SSL_VERIFY_NONE);
+      mbedtls_ssl_conf_rng(conf, mbedtls_ctr_drbg_random, &sslclient->drbg_ctx);
+      if ((ret = mbedtls_ssl_setup(ssl, conf)) != 0 || (ret = mbedtls_ssl_set_hostname(ssl, host)) != 0) return ret;
+      mbedtls_ssl_set_bio(ssl, &sslclient->socket, mbedtls_net_send, mbedtls_net_recv, nullptr);
+
+      uint32_t msStart = clockMs();
+      while ((ret = mbedtls_ssl_handshake(ssl)) == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE)
+      {
+        if (clockMs() - msStart > TLS_HANDSHAKE_MS) return -1;
+        clockSleep(10);
+      }
+      if (ret != 0) log_w("TLS handshake with %s failed: -0x%04x", host, -ret);
+      return ret;
+    }
+};
+
+struct PoolSlot
+{
+  char              host[64];
+  uint16_t          port;
+  bool              tls;
+  bool              inUse;
+  uint32_t          msLastUsed;
+  WiFiClient        plain;
+  RacedSecureClient secure;
+
+  WiFiClient *client() { return tls ? &secure : &plain; }
+};
+
+static PoolSlot slots[HTTP_POOL_SOCKETS];
+static SemaphoreHandle_t poolMutex = xSemaphoreCreateMutex();
+
+
+/**
+ * Connect the slot to the first address of its host which answers.
+ * Both clients take over the socket which won the race, a TLS client 
+ * runs its handshake over it with the host name for SNI.
+ */
+static bool connectSlot(PoolSlot &s)
+{
+  IPAddress ip;
+  int fd = raceConnect(s.host, s.port, ip);
+  if (fd < 0) return false;
+  if (!s.tls)
+  {
+    s.plain = WiFiClient(fd);
+    return true;
+  }
+  return s.secure.adopt(fd, s.host);
+}
+
+
+/**
+ * Get a connected client for host:port. A warm connection to the same 
+ * host is preferred, otherwise a free slot is taken, if necessary by 
+ * closing the least recently used idle connection. Returns nullptr when 
+ * all slots are in use or the host cannot be reached.
+ */
+WiFiClient *httpPoolAcquire(const char *host, uint16_t port, bool tls)
+{
+  PoolSlot *found = nullptr, *lru = nullptr;
+
+  xSemaphoreTake(poolMutex, portMAX_DELAY);
+  for (auto &s : slots)
+  {
+    if (s.inUse) continue;
+    if (s.port == port && s.tls == tls && strcmp(s.host, host) == 0 && s.client()->connected())
+    {
+      found = &s;
+      break;
+    }
+    if (lru == nullptr || !s.client()->connected() || 
+        (lru->client()->connected() && (int32_t)(s.msLastUsed - lru->msLastUsed) < 0)) lru = &s;
+  }
+
+  if (found)
+  {
+    metricAdd(HTTP_REUSED);
+    if (tls) metricAdd(TLS_HANDSHAKES_AVOIDED);
+  }
+  else if (lru)
+  {
+    found = lru;
+    found->client()->stop();
+    strncpy(found->host, host, sizeof(found->host) - 1);
+    found->host[sizeof(found->host) - 1] = '\0';
+    found->port = port;
+    found->tls  = tls;
+    if (tls) found->secure.setInsecure();
+  }
+  else 
+  {
+    metricAdd(HTTP_POOL_EXHAUSTED);
+  }
+  if (found) found->inUse = true;
+  xSemaphoreGive(poolMutex);
+
+  if (found && found == lru)
+  {
+    if (! connectSlot(*found))
+    {
+      httpPoolRelease(found->client(), false);
+      return nullptr;
+    }
+    metricAdd(HTTP_CONNECTS);
+  }
+  return found ? found->client() : nullptr;
+}
+
+
+/**
+ * Give the client back to the pool. Unless keepAlive is set 
+ * the connection is closed.
+ */
+void httpPoolRelease(WiFiClient *client, bool keepAlive)
+{
+  xSemaphoreTake(poolMutex, portMAX_DELAY);
+  for (auto &s : slots)
+  {
+    if (s.client() != client) continue;
+    if (!keepAlive) client->stop();
+    s.msLastUsed = clockMs();
+    s.inUse = false;
+  }
+  xSemaphoreGive(poolMutex);
+}
+
+
+/**
+ * Close connections which have been idle for too long
+ */
+void httpPoolMaintain()
+{
+  xSemaphoreTake(poolMutex, portMAX_DELAY);
+  for (auto &s : slots)
+  {
+    if (!s.inUse && s.client()->connected() && clockMs() - s.msLastUsed > HTTP_POOL_IDLE_MS) s.client()->stop();
+  }
+  xSemaphoreGive(poolMutex);
+}
+
+
+/**
+ * Split an url into scheme, host, port and path
+ */
+bool splitUrl(const char *url, bool &tls, char *host, size_t hostSize, uint16_t &port, const char *&path)
+{
+  if      (strncmp(url, "http://", 7) == 0)  { tls = false; port = 80;  url += 7; }
+  else if (strncmp(url, "https://", 8) == 0) { tls = true;  port = 443; url += 8; }
+  else return false;
+
+  size_t n = strcspn(url, ":/?");
+  if (n == 0 || n >= hostSize) return false;
+  memcpy(host, url, n);
+  host[n] = '\0';
+  url += n;
+  if (*url == ':') port = strtoul(url + 1, (char **)&url, 10);
+  path = *url ? url : "/";
+  return true;
+}
+
+
+/**
+ * Sink for HTTPClient::writeToStream(), which takes care of the content 
+ * length and decodes chunked bodies. It keeps the start of the body and 
+ * drops the rest, so the response is read completely.
+ */
+class BodyBuffer : public Stream
+{
+  public:
+    BodyBuffer(char *buf, size_t size) : _buf(buf), _size(size) { _buf[0] = '\0'; }
+
+    size_t write(const uint8_t *buf, size_t size) override
+    {
+      size_t n = std::min(size, _size - 1 - _len);
+      memcpy(_buf + _len, buf, n);
+      _len += n;
+      _buf[_len] = '\0';
+      return size;
+    }
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    int available() override         { return 0; }
+    int read() override              { return -1; }
+    int peek() override              { return -1; }
+
+  private:
+    char  *_buf;
+    size_t _size, _len = 0;
+};
+
+
+/**
+ * GET a small resource like a playlist through the pool and copy 
+ * the start of the body into the buffer. Redirects are followed 
+ * here, so each hop can use its own pooled connection. Returns 
+ * the HTTP status or a negative HTTPClient error.
+ */
+int httpFetch(const char *url, char *body, size_t size)
+{
+  static const char *headerKeys[] = { "Location" };
+  char location[256];
+  char host[64];
+  const char *path;
+  uint16_t port;
+  bool tls;
+  int code = -1;
+
+  body[0] = '\0';
+  for (uint8_t hop = 0; hop <= HTTP_MAX_REDIRECTS; hop++)
+  {
+    if (! splitUrl(url, tls, host, sizeof(host), port, path)) return -1;
+    WiFiClient *client = httpPoolAcquire(host, port, tls);
+    if (client == nullptr) return -1;
+
+    HTTPClient http;
+    http.setReuse(true);
+    http.setFollowRedirects(HTTPC_DISABLE_FOLLOW_REDIRECTS);
+    http.collectHeaders(headerKeys, 1);
+    http.setTimeout(HTTP_FETCH_TIMEOUT);
+    http.begin(*client, host, port, path, tls);
+    code = http.GET();
+    metricAdd(HTTP_REQUESTS);
+
+    if (code == 301 || code == 302 || code == 303 || code == 307 || code == 308)
+    {
+      strncpy(location, http.header("Location").c_str(), sizeof(location) - 1);
+      location[sizeof(location) - 1] = '\0';
+      url = location;
+      http.end();
+      httpPoolRelease(client, false);
+      continue;
+    }
+    int bytes = -1;
+    if (code == HTTP_CODE_OK)
+    {
+      BodyBuffer sink(body, size);
+      bytes = http.writeToStream(&sink);
+      if (bytes < 0) log_w("Fetch of %s failed: %s", url, HTTPClient::errorToString(bytes).c_str());
+    }
+    // keep the connection only when the response has been consumed completely
+    bool keepAlive = bytes >= 0 && client->connected();
+    http.end();
+    httpPoolRelease(client, keepAlive);
+    break;
+  }
+  return code;
+}
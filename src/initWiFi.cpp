@@ -1,5 +1,6 @@
 #include <Arduino.h>
 #include <WiFi.h>
+#include "initWiFi.h"
 
 /**
  * Print nearby WiFi networks with SSID und RSSI 
@@ -0,0 +1,35 @@
+#include <Arduino.h>
+#include "scheduler.h"
+#include "httpPool.h"
+#include "menu.h"
+#include "prebufferReport.h"
+#include "ttsCache.h"
+#include "jobs.h"
+
+
+/**
+ * Check for a stable stream every 500 ms until 
+ * the pre-rendering of the announcements starts
+ */
+static void ttsPrerenderJob(void *)
+{
+  if (!ttsPrerenderPoll()) addTimer("tts prerender", 500, 0, JOB_LOW, ttsPrerenderJob);
+}
+
+
+/**
+ * Periodic background work, the scheduler runs 
+ * it on core 0 and accounts the runtime of each job
+ */
+void startJobs()
+{
+  // show menu once after all status and info messages have been displayed
+  addTimer("show menu",       5000,    0, JOB_NORMAL, [](void *) { showMenu(""); });
+  // report the pre-buffering of a new stream
+  addTimer("prebuffer report",  50,   50, JOB_NORMAL, [](void *) { prebufferPoll(); });
+  // pre-render the announcements in the background once the stream is stable
+  addTimer("tts prerender",   5000,    0, JOB_LOW,    ttsPrerenderJob);
+  // close idle pooled connections
+  addTimer("http pool",       1000, 1000, JOB_LOW,    [](void *) { httpPoolMaintain(); });
+  startScheduler();
+}
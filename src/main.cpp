@@ -83,7 +83,35 @@
 
 #include <Arduino.h>
 #include <WiFi.h>
+#include <LittleFS.h>
+#include <freertos/semphr.h>
 #include "Audio.h"
+#include "readAheadFS.h"
+#include "metrics.h"
+#include "httpPool.h"
+#include "scheduler.h"
+#include "memPolicy.h"
+#include "clock.h"
+#include "menuKeys.h"
+#include "heartbeat.h"
+#include "initWiFi.h"
+#include "fileSystems.h"
+#include "ttsCache.h"
+#include "titleHistory.h"
+#include "charset.h"
+#include "playlist.h"
+#include "prebufferReport.h"
+#include "dsp.h"
+#include "benchmark.h"
+#include "powerMode.h"
+#include "audioTask.h"
+#include "display.h"
+#include "jobs.h"
+#include "webUi.h"
+#include "netProbe.h"
+#include "recorder.h"
+#include "mirrors.h"
+#include "menu.h"
  
 // I2S pins
 #define I2S_LRC        GPIO_NUM_25  // LRC  of MAX98357
@@ -94,22 +122,29 @@
 #define MIN_VOLUME     0
 #define MAX_VOLUME     21
 #define DEFAULT_VOLUME 10
+#define MONO_OUTPUT    false  // true for a single MAX98357A in mono mode
 
-extern void heartbeat(uint8_t pin, uint8_t nBeats, uint8_t t, uint8_t duty);
-extern bool initWiFi(const char ssid[], const char password[], const char hostname[]);
-extern void printNearbyNetworks();
-extern void printConnectionDetails();
-
+void announceStation(const char*);
 void decrementVolume(const char*);
 void incrementVolume(const char*);
 void playRadio(const char*);
 void playMP3(const char*);
+void playMP3LittleFS(const char*);
 void showCurrentStation(const char*);
 void showMenu(const char*);
+void showHistory(const char*);
 void textToSpeachDe(const char*);
 void textToSpeachEn(const char*);
 void textToSpeachIt(const char*);
 void toggleSpeaker(const char*);
+void toggleMono(const char*);
+void toggleDither(const char*);
+void toggleLowPower(const char*);
+void benchmark(const char*);
+void benchmarkCsv(const char*);
+void toggleZone(const char*);
+void playRecording(const char*);
+void playStation(uint8_t zone, int station);
 
 // WiFi credentials 
 const char ssid[]     = "DodekaGast";
@@ -155,14 +190,34 @@ MenuItem menu[] =
   { 'l', "Capital London",    "http://vis.media-ice.musicradio.com/CapitalMP3", playRadio },
   { 'm', "ORF",               "https://orf-live.ors-shoutcast.at/vbg-q1a",      playRadio },
   { 'n', "Beatles Radio",     "http://www.beatlesradio.com:8000/stream/1/",     playRadio },
+  { 'o', "SRF3 HE-AAC 96",    "http://stream.srg-ssr.ch/m/drs3/aacp_96",        playRadio },
+  { 'p', "Swiss Jazz HE-AAC 32", "http://stream.srg-ssr.ch/m/rsj/aacp_32",      playRadio },
   { '!', "Text to speach en",     text[0], textToSpeachEn },
   { '.', "Text to speach de",     text[1], textToSpeachDe },
   { ',', "Text to speach it",     text[2], textToSpeachIt },
   { 't', "Test stereo channels", "/stereotest440-445.mp3", playMP3 },
+  { 'u', "Test stereo from LittleFS", "/stereotest440-445.mp3", playMP3LittleFS },
+  { 'w', "Record SRF4 News on/off", "http://stream.srg-ssr.ch/m/drs4news/mp3_128", toggleRecording },
+  { 'y', "Play last recording",   "", playRecording },
+  { 'B', "Benchmark file systems", "", benchmarkFileSystems },
+  { 'X', "Benchmark this board",  "", benchmark },
+  { 'x', "Benchmark as CSV",      "", benchmarkCsv },
   { '+', "Increment volume",      "", incrementVolume },
   { '-', "Decrement volume",      "", decrementVolume },
   { 'T', "Toggle speaker on/off", "", toggleSpeaker },
+  { 'O', "Toggle mono output",    "", toggleMono },
+  { 'D', "Toggle dither",         "", toggleDither },
+  { 'P', "Toggle low power for current station", "", toggleLowPower },
+  { 'Z', "Toggle zone for the keys", "", toggleZone },
   { 'C', "Show current Station",  "", showCurrentStation },
+  { 'A', "Announce current Station", "", announceStation },
+  { 'H', "Show title history",    "", showHistory },
+  { 'M', "Show metrics",          "", showMetrics },
+  { 'J', "Show jobs",             "", showJobs },
+  { 'L', "Show memory layout",    "", showMemLayout },
+  { 'N', "Network probe",         "", networkProbe },
+  { 'V', "Show virtual display",  "", showDisplay },
+  { 'R', "Resync self test",      "", resyncSelfTest },
   { 'S', "Show Menu",             "", showMenu },
 };
 constexpr uint8_t nbrMenuItems = sizeof(menu) / sizeof(menu[0]);
@@ -170,6 +225,18 @@ constexpr uint8_t nbrMenuItems = sizeof(menu) / sizeof(menu[0]);
 int currentStation     = 5;  // preselect Swiss Classic
 const char *currentUrl = menu[currentStation].arg;
 int currentVolume      = DEFAULT_VOLUME;
+bool monoOutput        = MONO_OUTPUT;
+bool lowPower[nbrMenuItems]; 
+const char lowPowerStations[] = "56";  // keys of stations for background music
+bool resumeAfterAnnouncement[2];
+uint8_t menuZone       = 0;  // zone the keys act on, zone 2 plays on I2S1
+int zone2Station       = -1;
+const char *zone2Url   = nullptr;
+int zone2Volume        = DEFAULT_VOLUME;
+
+Audio &menuAudio()  { return zoneAudio(menuZone); }
+int &menuVolume()   { return menuZone ? zone2Volume : currentVolume; }
+int menuStation()   { return menuZone ? zone2Station : currentStation; }
 
 /**
  * Print name and url of current station
@@ -177,10 +244,20 @@ int currentVolume      = DEFAULT_VOLUME;
 void showCurrentStation(const char* txt) 
 {
   CLEAR_LINE;
-  Serial.printf("Current Station: %s --> %s", menu[currentStation].txt, currentUrl);
+  if (menuStation() < 0) { Serial.printf("Zone %d is off", menuZone + 1); return; }
+  Serial.printf("Zone %d: %s --> %s", menuZone + 1, menu[menuStation()].txt, menuZone ? zone2Url : currentUrl);
 };
 
 
+/**
+ * Print the titles played on the current station during the last hour
+ */
+void showHistory(const char* txt)
+{
+  if (menuStation() >= 0) showTitleHistory(menuStation());
+}
+
+
 /**
  * Display menu on monitor
  */
@@ -207,13 +284,15 @@ void showMenu(const char* txt)
  */
 void incrementVolume(const char* txt)
 {
-  if (currentVolume < MAX_VOLUME) 
+  int &volume = menuVolume();
+  if (volume < MAX_VOLUME) 
   {
-    currentVolume++;
-    audio.setVolume(currentVolume);
+    volume++;
+    setDigitalVolume(menuZone, volume, MAX_VOLUME);
   }
+  displayVolume(menuZone, volume);
   CLEAR_LINE;
-  Serial.printf("Current Volume: %d", currentVolume);
+  Serial.printf("Zone %d Volume: %d", menuZone + 1, volume);
 }
 
 
@@ -222,13 +301,15 @@ void incrementVolume(const char* txt)
  */
 void decrementVolume(const char* txt)
 {
-  if (currentVolume > 0) 
+  int &volume = menuVolume();
+  if (volume > 0) 
   {
-    currentVolume--;
-    audio.setVolume(currentVolume); // 0...21
+    volume--;
+    setDigitalVolume(menuZone, volume, MAX_VOLUME); // 0...21
   }
+  displayVolume(menuZone, volume);
   CLEAR_LINE;
-  Serial.printf("Current Volume: %d", currentVolume);
+  Serial.printf("Zone %d Volume: %d", menuZone + 1, volume);
 }
 
 
@@ -239,50 +320,285 @@ void decrementVolume(const char* txt)
  */
 void toggleSpeaker(const char* txt)
 {
-  static bool spkrIsOn = true;
-  if (spkrIsOn)
+  static bool spkrIsOn[2] = { true, true };
+  if (spkrIsOn[menuZone])
   {
-    audio.setVolume(MIN_VOLUME);
-    spkrIsOn = false;
+    setDigitalVolume(menuZone, MIN_VOLUME, MAX_VOLUME);
+    displayVolume(menuZone, MIN_VOLUME);
+    spkrIsOn[menuZone] = false;
     CLEAR_LINE;
     Serial.printf("Speaker is off");
   }
   else
   {
-    if (currentVolume == MIN_VOLUME) currentVolume = DEFAULT_VOLUME;
-    audio.setVolume(currentVolume);
-    spkrIsOn = true;
+    int &volume = menuVolume();
+    if (volume == MIN_VOLUME) volume = DEFAULT_VOLUME;
+    setDigitalVolume(menuZone, volume, MAX_VOLUME);
+    displayVolume(menuZone, volume);
+    spkrIsOn[menuZone] = true;
     CLEAR_LINE;
     Serial.printf("Speaker is on");
   }
 }
 
 
+/**
+ * Toggle the dither applied when the volume 
+ * stage reduces the samples to 16 bits
+ */
+void toggleDither(const char* txt)
+{
+  setDither(!ditherEnabled());
+  CLEAR_LINE;
+  Serial.printf("Dither is %s", ditherEnabled() ? "on" : "off");
+}
+
+
+/**
+ * Toggle between stereo and mono output. The library mixes the 
+ * channels after decoding, the benchmark measures what it saves.
+ */
+void toggleMono(const char* txt)
+{
+  monoOutput = !monoOutput;
+  audio.forceMono(monoOutput);
+  CLEAR_LINE;
+  Serial.printf("Output is %s", monoOutput ? "mono" : "stereo");
+}
+
+
+/**
+ * Toggle the low power mode of the current station, 
+ * see the metrics for CPU clock and load
+ */
+void toggleLowPower(const char* txt)
+{
+  lowPower[currentStation] = !lowPower[currentStation];
+  applyPowerMode(lowPower[currentStation]);
+  CLEAR_LINE;
+  Serial.printf("%s: low power %s", menu[currentStation].txt, lowPower[currentStation] ? "on" : "off");
+}
+
+
+/**
+ * Toggle the zone the keys act on
+ */
+void toggleZone(const char* txt)
+{
+  menuZone = 1 - menuZone;
+  CLEAR_LINE;
+  Serial.printf("Keys act on zone %d", menuZone + 1);
+}
+
+
+/**
+ * Run the benchmarks, which need the audio 
+ * path for themselves, then resume the station
+ */
+void benchmark(const char* txt)
+{
+  runBenchmarks(false);
+  playStation(0, currentStation);
+}
+
+void benchmarkCsv(const char* txt)
+{
+  runBenchmarks(true);
+  playStation(0, currentStation);
+}
+
+
+/**
+ * Check that the source does not need the 
+ * decoder of the other zone
+ */
+bool claimZone(uint8_t zone, const char *source)
+{
+  if (!zoneCanPlay(zone, source))
+  {
+    CLEAR_LINE;
+    Serial.printf("Zone %d: the codec is in use by the other zone", zone + 1);
+    return false;
+  }
+  return true;
+}
+
+
+/**
+ * Connect a zone to a station, playlists are resolved over 
+ * a pooled keep-alive connection. Stations with a mirror are 
+ * received over both paths in zone 1. The playlist is fetched 
+ * before the audio lock is taken, so the audio task keeps the 
+ * other zone playing meanwhile. The station becomes the one 
+ * of the zone only once its codec is free.
+ */
+void playStation(uint8_t zone, int station)
+{
+  static SemaphoreHandle_t stationMutex = xSemaphoreCreateMutex();   // one station change at a time
+  xSemaphoreTake(stationMutex, portMAX_DELAY);
+  const char *url = resolvePlaylist(menu[station].arg);
+
+  audioLock();
+  bool claimed = claimZone(zone, menu[station].arg);
+  if (claimed && zone == 1)
+  {
+    zone2Station = station;
+    zone2Url = menu[station].arg;
+    zoneAudio(1).connecttohost(url);
+  }
+  else if (claimed)
+  {
+    currentStation = station;
+    currentUrl = menu[station].arg;
+    applyPowerMode(lowPower[currentStation]);
+    displayStation(menu[currentStation].txt);
+    displayTitle("");
+    if (!connectMirrored(audio, url)) audio.connecttohost(url);
+    streamStarted(url);
+  }
+  audioUnlock();
+  xSemaphoreGive(stationMutex);
+}
+
+/**
+ * Menu action of the stations, it takes the audio lock itself
+ */
 void playRadio(const char* txt)
 {
-  audio.connecttohost(txt);
+  for (int i = 0; i < nbrMenuItems; i++) 
+  {
+    if (menu[i].arg == txt && &menu[i].action == &playRadio) playStation(menuZone, i);
+  }
 }
 
+/**
+ * Play a file from SPIFFS or LittleFS, both 
+ * are read through the read-ahead layer
+ */
 void playMP3(const char* file)
 {
-  audio.connecttoFS(SPIFFS, file);   
+  if (claimZone(menuZone, file)) menuAudio().connecttoFS(spiffsRA, file);   
+}
+
+void playMP3LittleFS(const char* file)
+{
+  if (claimZone(menuZone, file)) menuAudio().connecttoFS(littlefsRA, file);   
+}
+
+void playRecording(const char* txt)
+{
+  if (*lastRecording()) playMP3LittleFS(lastRecording());
 }
 
 void textToSpeachDe(const char* txt)
 {
-  audio.connecttospeech(txt, "de");
+  if (claimZone(menuZone, "mp3")) speak(menuAudio(), txt, "de");
 }
 
 
 void textToSpeachEn(const char* txt)
 {
-  audio.connecttospeech(txt, "en");
+  if (claimZone(menuZone, "mp3")) speak(menuAudio(), txt, "en");
 }
 
 
 void textToSpeachIt(const char* txt)
 {
-  audio.connecttospeech(txt, "it");
+  if (claimZone(menuZone, "mp3")) speak(menuAudio(), txt, "it");
+}
+
+
+/**
+ * Speak the name of the current station and 
+ * resume the station afterwards
+ */
+void announceStation(const char* txt)
+{
+  if (menuStation() < 0 || !claimZone(menuZone, "mp3")) return;
+  resumeAfterAnnouncement[menuZone] = true;
+  speak(menuAudio(), menu[menuStation()].txt, "de");
+}
+
+
+/**
+ * Resume the station of the zone whose announcement has ended. 
+ * The callback runs in the audio task, the scheduler resolves 
+ * and connects the station outside of it.
+ */
+void resumeStation()
+{
+  uint8_t zone = currentZone();
+  if (!resumeAfterAnnouncement[zone]) return;
+  resumeAfterAnnouncement[zone] = false;
+  addTimer("resume station", 0, 0, JOB_NORMAL, [](void *ctx) 
+  { 
+    uint8_t zone = (uintptr_t)ctx;
+    playStation(zone, zone ? zone2Station : currentStation);
+    wakeAudioTask();
+  }, (void *)(uintptr_t)zone);
+}
+
+
+/**
+ * Register the fixed announcement texts and station 
+ * names for background pre-rendering
+ */
+void initTtsCache()
+{
+  for (int i = 0; i < nbrMenuItems; i++)
+  {
+    if (&menu[i].action == &textToSpeachEn) addTtsJob(menu[i].arg, "en");
+    if (&menu[i].action == &textToSpeachDe) addTtsJob(menu[i].arg, "de");
+    if (&menu[i].action == &textToSpeachIt) addTtsJob(menu[i].arg, "it");
+    if (&menu[i].action == &playRadio)      addTtsJob(menu[i].txt, "de");
+  }
+}
+
+
+/**
+ * Index the menu by key for runMenuKey()
+ */
+void initMenuKeys()
+{
+  for (int i = 0; i < nbrMenuItems; i++) menuKeySet(menu[i].key, i);
+}
+
+
+/**
+ * Index of the menu item of a key, -1 if there is none
+ */
+int findMenuItem(char key)
+{
+  return menuKeyFind(key);
+}
+
+
+/**
+ * Perform the action of a key, from the monitor or the web UI, 
+ * with the audio lock held. The benchmarks take seconds, they 
+ * pause the audio task instead. The stations lock only around 
+ * the calls into the audio objects. Returns false for unknown keys.
+ */
+bool runMenuKey(char key)
+{
+  int i = findMenuItem(key);
+  if (i < 0) return false;
+
+  if (&menu[i].action == &benchmark || &menu[i].action == &benchmarkCsv || &menu[i].action == &benchmarkFileSystems)
+  {
+    pauseAudioTask(true);
+    menu[i].action(menu[i].arg);
+    pauseAudioTask(false);
+    wakeAudioTask();
+    return true;
+  }
+
+  bool locked = &menu[i].action != &playRadio;
+  if (locked) audioLock();
+  menu[i].action(menu[i].arg);
+  if (locked) audioUnlock();
+  wakeAudioTask();
+  return true;
 }
 
 
@@ -294,17 +610,20 @@ void doMenu()
 {
   char key = Serial.read();
   CLEAR_LINE;
+  runMenuKey(key);
+}
 
-  for (int i = 0; i < nbrMenuItems; i++)
-  {
-    if (key == menu[i].key)
-    {
-      menu[i].action(menu[i].arg);
-      break;
-    }
-  } 
+
+/**
+ * Menu items for the web UI
+ */
+void listMenu(void (*cb)(char key, const char *txt, void *ctx), void *ctx)
+{
+  for (int i = 0; i < nbrMenuItems; i++) cb(menu[i].key, menu[i].txt, ctx);
 }
 
+const char *menuText(int item) { return menu[item].txt; }
+
 
 
 /**
@@ -313,8 +632,14 @@ void doMenu()
 void initAudio()
 {
   audio.setPinout(I2S_BCLK, I2S_LRC, I2S_DOUT);
-  audio.setVolume(currentVolume); // 0...21
-  audio.connecttohost(currentUrl);
+  audio.setVolume(MAX_VOLUME);     // full resolution for the digital volume
+  placeStreamBuffer(audio);
+  setDigitalVolume(0, currentVolume, MAX_VOLUME); // 0...21
+  setDigitalVolume(1, zone2Volume, MAX_VOLUME);
+  displayVolume(0, currentVolume);
+  audio.forceMono(monoOutput);
+  for (int i = 0; i < nbrMenuItems; i++) lowPower[i] = strchr(lowPowerStations, menu[i].key) != nullptr;
+  playStation(0, currentStation);
 
 /*   file = new AudioFileSourceSPIFFS("/stereotest440-445.mp3");
   id3 = new AudioFileSourceID3(file);
@@ -326,67 +651,74 @@ void initAudio()
   mp3->begin(id3, out);  */   
 }
 
-/**
- * Returns true, as soon as msWait milliseconds have passed.
- * Supply a reference to an unsigned long variable to hold 
- * the previous milliseconds.
- */
-bool waitIsOver(uint32_t &msPrevious, uint32_t msWait)
-{
-  return (millis() - msPrevious >= msWait) ? (msPrevious = millis(), true) : false;
-}
-
-
 void setup() 
 {
     Serial.begin(115200);
     pinMode(LED_BUILTIN, OUTPUT);
+    initMemPolicy();
+    initMenuKeys();
 
     if (! initWiFi(ssid, password, hostname))
     { 
       log_e("==> Connection to WLAN failed");
       while(true) heartbeat(LED_BUILTIN, 3, 1, 5);
     };
-    SPIFFS.begin();
+    initFileSystems();
     printNearbyNetworks();
     printConnectionDetails();
+    initTitleHistory();
+    initPrebufferReport();
+    initDisplay();
     initAudio();
+    showMemLayout("");
+    initTtsCache();
+    startAudioTask();
+    initWebUi();
+    startJobs();
 }
  
 
 void loop()
 {
-    static uint32_t msPrevious = millis();
-    static bool done = false;
-
-    audio.loop();
-
-    // show menu once after all status and info messages have been displayed
-    if (!done && waitIsOver(msPrevious, 5000)) { done = true; showMenu(""); }
+    // periodic work runs in the scheduler, see startJobs()
 
     // handle keystrokes and the menu
     if (Serial.available()) doMenu();    
+
+    // requests of the web UI
+    webUiPoll();
+
+    // the audio task refills I2S on its own, no need to spin here
+    clockSleep(10);
 }
  
 
 // optional event handlers
 void audio_info(const char *info){
     Serial.print("info        "); Serial.println(info);
+    dspOnInfo(info);
 }
 void audio_id3data(const char *info){  //id3 metadata
+    info = metadataToUtf8(info);
     Serial.print("id3data     ");Serial.println(info);
 }
 void audio_eof_mp3(const char *info){  //end of file
     Serial.print("eof_mp3     ");Serial.println(info);
+    resumeStation();
 }
-void audio_showstation(const char *info){
+void audio_showstation(const char *info){  //icy-name
+    info = metadataToUtf8(info);
     Serial.print("station     ");Serial.println(info);
 }
 void audio_showstreaminfo(const char *info){
     Serial.print("streaminfo  ");Serial.println(info);
 }
 void audio_showstreamtitle(const char *info){
+    info = metadataToUtf8(info);
     Serial.print("streamtitle ");Serial.println(info);
+    int station = currentZone() ? zone2Station : currentStation;
+    if (station >= 0) recordTitle(station, info);
+    if (currentZone() == 0) displayTitle(info);
 }
 void audio_bitrate(const char *info){
     Serial.print("bitrate     ");Serial.println(info);
@@ -402,4 +734,5 @@ void audio_lasthost(const char *info){  //stream URL played
 }
 void audio_eof_speech(const char *info){
     Serial.print("eof_speech  ");Serial.println(info);
+    resumeStation();
 }
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include "Audio.h"
+#include "memPolicy.h"
+#include "audioTask.h"
+
+#define STREAM_RAM_BYTES    16000    // the library default, fits WROOM boards
+#define STREAM_PSRAM_BYTES  262144   // 16 s at 128 kbit/s
+#define NOMINAL_KBPS        128      // bitrate for the buffer seconds at boot
+
+#define MEM_BUFFER_LABEL(id, label, size, bulk) label,
+static const char *labels[MEM_BUFFER_COUNT] = { MEM_BUFFERS(MEM_BUFFER_LABEL) };
+#undef MEM_BUFFER_LABEL
+
+#define MEM_BUFFER_SIZE(id, label, size, bulk) size,
+static uint32_t sizes[MEM_BUFFER_COUNT] = { MEM_BUFFERS(MEM_BUFFER_SIZE) };
+#undef MEM_BUFFER_SIZE
+
+#define MEM_BUFFER_BULK(id, label, size, bulk) bulk,
+static const bool bulk[MEM_BUFFER_COUNT] = { MEM_BUFFERS(MEM_BUFFER_BULK) };
+#undef MEM_BUFFER_BULK
+
+static bool inPsram[MEM_BUFFER_COUNT];
+static bool havePsram = false;
+
+
+/**
+ * Detect PSRAM and assign each buffer its memory
+ */
+void initMemPolicy()
+{
+  havePsram = psramFound();
+  for (uint8_t i = 0; i < MEM_BUFFER_COUNT; i++) inPsram[i] = havePsram && bulk[i];
+  sizes[MEM_STREAM] = havePsram ? STREAM_PSRAM_BYTES : STREAM_RAM_BYTES;
+}
+
+
+/**
+ * Allocate a buffer where the policy puts it, internal
+ * RAM serves as fallback when PSRAM is exhausted
+ */
+void *memAlloc(MemBuffer buf, size_t size)
+{
+  void *p = nullptr;
+  if (inPsram[buf]) p = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (p == nullptr) p = heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  return p;
+}
+
+
+/**
+ * Size the input buffer of an audio object, the library
+ * takes it from PSRAM if there is some. The library refuses
+ * once the buffer is allocated, then it keeps its size.
+ */
+void placeStreamBuffer(Audio &audio)
+{
+  if (!audio.setBufsize(STREAM_RAM_BYTES, STREAM_PSRAM_BYTES))
+    log_w("Stream buffer not resized, it has %u bytes", audio.getInBufferSize());
+}
+
+
+/**
+ * Print where the buffers go and how long the stream buffer lasts
+ */
+void showMemLayout(const char *txt)
+{
+  // the size the library reports, once it has one
+  uint32_t streamBytes = audio.getInBufferSize();
+  if (streamBytes) sizes[MEM_STREAM] = streamBytes;
+  Serial.printf("\r\nMemory layout, %s\r\n", havePsram ? "PSRAM found" : "no PSRAM");
+  for (uint8_t i = 0; i < MEM_BUFFER_COUNT; i++)
+  {
+    Serial.printf("  %-28s %8u bytes  %s\r\n", labels[i], sizes[i], inPsram[i] ? "psram" : "internal");
+  }
+  Serial.printf("  %-28s %8s        %s\r\n", "decoder state, i2s dma", "", "internal");
+#ifdef CONFIG_SPIRAM_MALLOC_ALWAYSINTERNAL
+  // the threshold arduino-esp32 sets when it adds the PSRAM to the heap
+  if (havePsram) Serial.printf("  %-28s %8u bytes  %s\r\n", "other mallocs from", CONFIG_SPIRAM_MALLOC_ALWAYSINTERNAL, "psram");
+#endif
+  Serial.printf("  stream buffer lasts %u ms at %u kbit/s\r\n", sizes[MEM_STREAM] * 8 / NOMINAL_KBPS, NOMINAL_KBPS);
+  Serial.printf("  free internal %u KB, largest block %u KB\r\n",
+                heap_caps_get_free_size(MALLOC_CAP_INTERNAL) >> 10, heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL) >> 10);
+  if (havePsram) Serial.printf("  free psram %u KB\r\n", heap_caps_get_free_size(MALLOC_CAP_SPIRAM) >> 10);
+}
@@ -0,0 +1,21 @@
+#include <Arduino.h>
+#include "menuKeys.h"
+
+#define MENU_KEYS 128   // ASCII, other keys have no item
+
+static uint8_t items[MENU_KEYS];   // item + 1, 0 for keys without an item
+
+
+void menuKeySet(char key, uint8_t item)
+{
+  if ((uint8_t)key < MENU_KEYS && item < UINT8_MAX) items[(uint8_t)key] = item + 1;
+}
+
+
+/**
+ * Index of the menu item of a key, -1 if there is none
+ */
+int menuKeyFind(char key)
+{
+  return (uint8_t)key < MENU_KEYS ? items[(uint8_t)key] - 1 : -1;
+}
@@ -0,0 +1,29 @@
+#include <Arduino.h>
+#include "metrics.h"
+
+#define METRIC_LABEL(id, label) label,
+static const char *labels[METRIC_COUNT] = { METRICS(METRIC_LABEL) };
+#undef METRIC_LABEL
+
+/**
+ * The audio task on core 1 and the network tasks on core 0 count 
+ * into the same metrics, so an add must not lose a concurrent one
+ */
+static int32_t values[METRIC_COUNT];
+
+void metricAdd(Metric m, int32_t n)     { __atomic_fetch_add(&values[m], n, __ATOMIC_RELAXED); }
+void metricSet(Metric m, int32_t value) { __atomic_store_n(&values[m], value, __ATOMIC_RELAXED); }
+int32_t metricGet(Metric m)             { return __atomic_load_n(&values[m], __ATOMIC_RELAXED); }
+
+
+/**
+ * Print all metrics on the monitor
+ */
+void showMetrics(const char* txt)
+{
+  Serial.printf("\r\nMetrics:\r\n--------\r\n");
+  for (uint8_t i = 0; i < METRIC_COUNT; i++)
+  {
+    Serial.printf("  %-28s %d\r\n", labels[i], metricGet((Metric)i));
+  }
+}
@@ -0,0 +1,360 @@
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <WiFiClientSecure.h>
+#include <freertos/semphr.h>
+#include "Audio.h"
+#include "splicer.h"
+#include "metrics.h"
+#include "clock.h"
+#include "memPolicy.h"
+#include "mirrors.h"
+
+#define MIRROR_RING_BYTES   16384   // about 1 s of frames at 128 kbit/s per path
+#define MIRROR_TASK_STACK   12288   // room for a TLS handshake
+#define MIRROR_TASK_PRIORITY (tskIDLE_PRIORITY + 2)
+#define MIRROR_STALL_MS     5000    // a path without data for that long reconnects
+#define RECONNECT_MIN_MS    1000
+#define RECONNECT_MAX_MS    16000
+#define STREAM_SIZE         0x7FFFFFFF   // the spliced stream has no end
+#define READ_WAIT_MS        26      // one frame at 44.1 kHz
+
+using namespace fs;
+
+extern void audio_showstreamtitle(const char *info);
+
+/**
+ * Stations received over two paths at once, relays of the same encoder
+ * on different servers. The first url is the one of the menu.
+ */
+static const char *mirrorPairs[][MIRRORS] =
+{
+  { "http://mdr-284350-0.cast.mdr.de/mdr/284350/0/mp3/high/stream.mp3",
+    "http://mdr-284350-1.cast.mdr.de/mdr/284350/1/mp3/high/stream.mp3" },
+  { "http://st01.dlf.de/dlf/01/128/mp3/stream.mp3",
+    "https://st01.sslstream.dlf.de/dlf/01/128/mp3/stream.mp3" },
+};
+
+
+/**
+ * Both paths of a station and their splicer. The receiver tasks and
+ * the open file each hold a reference, the last one deletes it.
+ */
+struct Session
+{
+  const char *url[MIRRORS];
+  uint8_t *ring[MIRRORS];
+  MirrorQueue queue[MIRRORS];
+  Splicer splicer{ queue[0], queue[1] };
+  SemaphoreHandle_t mutex = xSemaphoreCreateMutex();
+  char title[ICY_TITLE_MAX] = "";   // the title of either path, once it changes
+  bool titleNew = false;
+  volatile bool running = true;
+  uint8_t refs = 1;
+  portMUX_TYPE refMux = portMUX_INITIALIZER_UNLOCKED;
+
+  ~Session()
+  {
+    for (auto r : ring) free(r);
+    vSemaphoreDelete(mutex);
+  }
+};
+
+struct Receiver { Session *session; uint8_t path; };
+
+
+static void release(Session *s)
+{
+  portENTER_CRITICAL(&s->refMux);
+  bool last = --s->refs == 0;
+  portEXIT_CRITICAL(&s->refMux);
+  if (last) delete s;
+}
+
+
+/**
+ * Pass a title of a path on to the session, 
+ * unless the other path brought it already
+ */
+static void takeTitle(Session &s, IcyStripper &icy)
+{
+  char title[ICY_TITLE_MAX];
+  if (!icy.newTitle(title, sizeof(title))) return;
+  xSemaphoreTake(s.mutex, portMAX_DELAY);
+  if (strcmp(s.title, title) != 0)
+  {
+    strlcpy(s.title, title, sizeof(s.title));
+    s.titleNew = true;
+  }
+  xSemaphoreGive(s.mutex);
+}
+
+
+/**
+ * Receive one path until it fails or the session ends. The metadata 
+ * blocks are removed before the bytes reach the queue, which then 
+ * holds nothing but MP3 frames.
+ */
+static void receive(Session &s, uint8_t path)
+{
+  static const char *headerKeys[] = { "icy-metaint" };
+  HTTPClient http;
+  IcyStripper icy;
+  WiFiClient plain;
+  WiFiClientSecure secure;
+  secure.setInsecure();
+  WiFiClient &client = strncmp(s.url[path], "https:", 6) == 0 ? secure : plain;
+  http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
+  if (!http.begin(client, s.url[path])) return;
+  http.addHeader("Icy-MetaData", "1");
+  http.collectHeaders(headerKeys, 1);
+  int code = http.GET();
+  metricAdd(HTTP_REQUESTS);
+  if (code != HTTP_CODE_OK)
+  {
+    log_w("Mirror %s failed: %d", s.url[path], code);
+    http.end();
+    return;
+  }
+
+  WiFiClient *stream = http.getStreamPtr();
+  icy.begin(http.header("icy-metaint").toInt());
+  xSemaphoreTake(s.mutex, portMAX_DELAY);
+  s.queue[path].cut();
+  xSemaphoreGive(s.mutex);
+  uint8_t buf[512];
+  uint32_t msData = clockMs();
+  while (s.running && http.connected() && clockMs() - msData < MIRROR_STALL_MS)
+  {
+    xSemaphoreTake(s.mutex, portMAX_DELAY);
+    size_t space = s.queue[path].space();
+    xSemaphoreGive(s.mutex);
+    size_t avail = stream->available();
+    if (space == 0) msData = clockMs();   // the decoder is behind, not the path
+    if (avail == 0 || space == 0) { clockSleep(10); continue; }
+
+    int len = stream->read(buf, std::min({ avail, space, sizeof(buf) }));
+    if (len <= 0) break;
+    msData = clockMs();
+    len = icy.strip(buf, len);
+    takeTitle(s, icy);
+    xSemaphoreTake(s.mutex, portMAX_DELAY);
+    s.queue[path].append(buf, len);
+    xSemaphoreGive(s.mutex);
+  }
+  http.end();
+}
+
+
+/**
+ * Keep one path connected while the session runs, reconnecting
+ * with a growing delay while it fails right away
+ */
+static void receiverTask(void *arg)
+{
+  Receiver r = *(Receiver *)arg;
+  delete (Receiver *)arg;
+  Session &s = *r.session;
+  uint32_t backoff = RECONNECT_MIN_MS;
+
+  while (s.running)
+  {
+    uint32_t msStart = clockMs();
+    receive(s, r.path);
+    if (!s.running) break;
+    metricAdd(MIRROR_RECONNECTS);
+    backoff = clockMs() - msStart > RECONNECT_MAX_MS ? RECONNECT_MIN_MS : std::min<uint32_t>(backoff * 2, RECONNECT_MAX_MS);
+    for (uint32_t ms = 0; s.running && ms < backoff; ms += 100) clockSleep(100);
+  }
+  release(r.session);
+  vTaskDelete(NULL);
+}
+
+
+/**
+ * Start receiving both paths of a pair
+ */
+static Session *startSession(uint8_t pair)
+{
+  Session *s = new Session;
+  for (uint8_t i = 0; i < MIRRORS; i++)
+  {
+    s->url[i]  = mirrorPairs[pair][i];
+    s->ring[i] = (uint8_t *)memAlloc(MEM_MIRROR_FRAMES, MIRROR_RING_BYTES);
+    s->queue[i].begin(s->ring[i], MIRROR_RING_BYTES);
+  }
+  if (!s->ring[0] || !s->ring[1])
+  {
+    delete s;
+    return nullptr;
+  }
+  uint8_t started = 0;
+  for (uint8_t i = 0; i < MIRRORS; i++)
+  {
+    Receiver *r = new Receiver{ s, i };
+    portENTER_CRITICAL(&s->refMux);
+    s->refs++;
+    portEXIT_CRITICAL(&s->refMux);
+    if (xTaskCreatePinnedToCore(receiverTask, "mirror", MIRROR_TASK_STACK, r, MIRROR_TASK_PRIORITY, NULL, 0) == pdPASS)
+    {
+      started++;
+      continue;
+    }
+    log_w("Cannot start the receiver of %s", s->url[i]);
+    delete r;
+    release(s);
+  }
+  if (started == 0)
+  {
+    release(s);
+    return nullptr;
+  }
+  return s;
+}
+
+
+/**
+ * The spliced stream as an endless file for Audio::connecttoFS().
+ * Reads are served frame by frame from the splicer and return what
+ * is there. A read of 0 bytes may count as the end of a file for the
+ * library, so a read which finds no frame waits up to one frame time.
+ * Titles of the paths are passed on here, in the audio task of zone 1
+ * like those of the library. Closing the file stops the receivers.
+ */
+class SplicedFileImpl : public FileImpl
+{
+  public:
+    SplicedFileImpl(Session *s, const char *path) : _s(s)
+    {
+      strlcpy(_path, path, sizeof(_path));
+    }
+
+    ~SplicedFileImpl() { close(); }
+
+    size_t read(uint8_t *buf, size_t size) override
+    {
+      size_t done = 0;
+      uint32_t msStart = clockMs();
+      while (_s && done < size)
+      {
+        if (_framePos == _frameLen)
+        {
+          char title[ICY_TITLE_MAX] = "";
+          xSemaphoreTake(_s->mutex, portMAX_DELAY);
+          _frameLen = _s->splicer.next(_frame, clockMs());
+          publish();
+          if (_s->titleNew) strlcpy(title, _s->title, sizeof(title));
+          _s->titleNew = false;
+          xSemaphoreGive(_s->mutex);
+          if (*title) audio_showstreamtitle(title);
+          _framePos = 0;
+          if (_frameLen == 0 && done == 0 && clockMs() - msStart < READ_WAIT_MS) 
+          {
+            clockSleep(2);
+            continue;
+          }
+          if (_frameLen == 0) break;
+        }
+        size_t n = std::min(size - done, _frameLen - _framePos);
+        memcpy(buf + done, _frame + _framePos, n);
+        _framePos += n;
+        done += n;
+      }
+      _pos += done;
+      return done;
+    }
+
+    // a stream only seeks within the current frame
+    bool seek(uint32_t pos, SeekMode mode) override
+    {
+      int64_t target = mode == SeekCur ? (int64_t)_pos + pos : mode == SeekEnd ? (int64_t)STREAM_SIZE + pos : pos;
+      if (target > _pos || target < (int64_t)(_pos - _framePos)) return false;
+      _framePos -= _pos - target;
+      _pos = target;
+      return true;
+    }
+
+    void close() override
+    {
+      if (!_s) return;
+      _s->running = false;
+      release(_s);
+      _s = nullptr;
+    }
+
+    size_t write(const uint8_t *buf, size_t size) override { return 0; }
+    void flush() override                        {}
+    size_t position() const override             { return _pos; }
+    size_t size() const override                 { return STREAM_SIZE; }
+    bool setBufferSize(size_t size) override     { return false; }
+    time_t getLastWrite() override               { return 0; }
+    const char *path() const override            { return _path; }
+    const char *name() const override            { return _path + 1; }
+    boolean isDirectory(void) override           { return false; }
+    void rewindDirectory(void) override          {}
+    operator bool() override                     { return _s != nullptr; }
+    FileImplPtr openNextFile(const char *mode) override { return FileImplPtr(); }
+
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+    boolean seekDir(long position) override      { return false; }
+    String getNextFileName(void) override        { return ""; }
+    String getNextFileName(bool *isDir) override { return ""; }
+#endif
+
+  private:
+    void publish()
+    {
+      metricSet(MIRROR_FRAMES_1, _s->splicer.frames[0]);
+      metricSet(MIRROR_FRAMES_2, _s->splicer.frames[1]);
+      metricSet(MIRROR_SWITCHES, _s->splicer.switches);
+      metricSet(SPLICE_JUMPS, _s->splicer.jumps);
+      metricSet(MIRROR_RESYNCS, _s->queue[0].resyncs + _s->queue[1].resyncs);
+      metricSet(MIRROR_SKIPPED_BYTES, _s->queue[0].skippedBytes + _s->queue[1].skippedBytes);
+    }
+
+    Session *_s;
+    char     _path[16];
+    uint8_t  _frame[FRAME_MAX_LEN];
+    size_t   _frameLen = 0, _framePos = 0;
+    uint32_t _pos = 0;
+};
+
+
+/**
+ * Opening /<pair>.mp3 starts the receivers of that pair
+ */
+class SplicedFSImpl : public FSImpl
+{
+  public:
+    FileImplPtr open(const char *path, const char *mode, const bool create) override
+    {
+      unsigned pair = atoi(path + 1);
+      if (pair >= sizeof(mirrorPairs) / sizeof(mirrorPairs[0])) return FileImplPtr();
+      Session *s = startSession(pair);
+      return s ? std::make_shared<SplicedFileImpl>(s, path) : FileImplPtr();
+    }
+
+    bool exists(const char *path) override                      { return atoi(path + 1) < (int)(sizeof(mirrorPairs) / sizeof(mirrorPairs[0])); }
+    bool rename(const char *pathFrom, const char *pathTo) override { return false; }
+    bool remove(const char *path) override                      { return false; }
+    bool mkdir(const char *path) override                       { return false; }
+    bool rmdir(const char *path) override                       { return false; }
+};
+
+static FS splicedFS(std::make_shared<SplicedFSImpl>());
+
+
+/**
+ * Play url over both paths of its pair and splice them. Returns
+ * false if url has no pair or the session cannot be started.
+ */
+bool connectMirrored(Audio &out, const char *url)
+{
+  for (uint8_t i = 0; i < sizeof(mirrorPairs) / sizeof(mirrorPairs[0]); i++)
+  {
+    if (strcmp(url, mirrorPairs[i][0]) != 0) continue;
+    char path[16];
+    snprintf(path, sizeof(path), "/%u.mp3", i);
+    return out.connecttoFS(splicedFS, path);
+  }
+  return false;
+}
@@ -0,0 +1,65 @@
+#include <Arduino.h>
+#include "mp3Sync.h"
+
+static const uint16_t bitrates[2][16] =   // kbps, layer III, [MPEG1, MPEG2/2.5]
+{
+  { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 0 },
+  { 0,  8, 16, 24, 32, 40, 48, 56,  64,  80,  96, 112, 128, 144, 160, 0 },
+};
+static const uint32_t sampleRates[4][3] = // [version id], 1 = reserved
+{
+  { 11025, 12000,  8000 },  // MPEG 2.5
+  {     0,     0,     0 },
+  { 22050, 24000, 16000 },  // MPEG 2
+  { 44100, 48000, 32000 },  // MPEG 1
+};
+
+
+/**
+ * Parse a layer III frame header, returns false for anything 
+ * which cannot be the start of a valid frame
+ */
+bool parseMp3Header(const uint8_t *p, Mp3Header &h)
+{
+  if (p[0] != 0xFF || (p[1] & 0xE0) != 0xE0) return false;
+  uint8_t versionId = (p[1] >> 3) & 3;
+  uint8_t layer     = (p[1] >> 1) & 3;
+  uint8_t brIndex   = p[2] >> 4;
+  uint8_t srIndex   = (p[2] >> 2) & 3;
+  uint8_t padding   = (p[2] >> 1) & 1;
+  if (versionId == 1 || layer != 1 || brIndex == 0 || brIndex == 15 || srIndex == 3) return false;
+
+  h.version    = versionId;
+  h.layer      = 3;
+  h.sampleRate = sampleRates[versionId][srIndex];
+  uint32_t bitrate = bitrates[versionId == 3 ? 0 : 1][brIndex] * 1000;
+  uint32_t samples = versionId == 3 ? 144 : 72;  // samples per frame / 8
+  h.frameLen   = samples * bitrate / h.sampleRate + padding;
+  return true;
+}
+
+
+/**
+ * Find the first offset in buf where a chain of SYNC_CHAIN frame headers 
+ * with the same version and sample rate follow each other exactly one 
+ * frame length apart. A single 11 bit syncword matches random data all 
+ * the time, a chain of 3 practically never. Returns -1 if none is found.
+ */
+int32_t mp3FindSync(const uint8_t *buf, size_t len)
+{
+  Mp3Header first, next;
+  for (size_t i = 0; i + 4 <= len; i++)
+  {
+    if (!parseMp3Header(buf + i, first)) continue;
+    size_t pos = i + first.frameLen;
+    uint8_t chain = 1;
+    while (chain < SYNC_CHAIN && pos + 4 <= len && parseMp3Header(buf + pos, next) &&
+           next.version == first.version && next.sampleRate == first.sampleRate)
+    {
+      pos += next.frameLen;
+      chain++;
+    }
+    if (chain == SYNC_CHAIN) return i;
+  }
+  return -1;
+}
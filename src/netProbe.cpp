@@ -0,0 +1,171 @@
+#include <Arduino.h>
+#include <WiFi.h>
+#include <esp_wifi.h>
+#include <lwip/stats.h>
+#include "metrics.h"
+#include "clock.h"
+#include "audioTask.h"
+#include "netProbe.h"
+
+#define PROBE_RTT_SAMPLES   5
+#define PROBE_SECONDS       3
+#define PROBE_TIMEOUT_MS    2000
+#define PROBE_SERVER        "192.168.1.10:5001"   // until set with setProbeServer()
+
+static TaskHandle_t probeTask = nullptr;
+static char probeServer[64] = PROBE_SERVER;
+static char server[64];               // copy the task reads while busy
+static volatile bool busy = false;
+
+
+/**
+ * TCP retransmissions since boot, if lwIP keeps statistics
+ */
+static int32_t retransmissions()
+{
+#if LWIP_STATS && TCP_STATS
+  return lwip_stats.tcp.rexmit;
+#else
+  return -1;
+#endif
+}
+
+
+/**
+ * Smallest TCP connect time of a few tries in ms, -1 if unreachable
+ */
+static int32_t measureRtt(IPAddress ip, uint16_t port)
+{
+  int32_t best = -1;
+  for (int i = 0; i < PROBE_RTT_SAMPLES; i++)
+  {
+    WiFiClient client;
+    uint32_t msStart = clockMs();
+    if (client.connect(ip, port, PROBE_TIMEOUT_MS))
+    {
+      int32_t ms = clockMs() - msStart;
+      if (best < 0 || ms < best) best = ms;
+    }
+    client.stop();
+  }
+  return best;
+}
+
+
+/**
+ * Receive from the server for a few seconds, returns kbit/s
+ */
+static uint32_t measureThroughput(IPAddress ip, uint16_t port)
+{
+  WiFiClient client;
+  if (!client.connect(ip, port, PROBE_TIMEOUT_MS)) return 0;
+  static uint8_t buf[1460];
+  uint32_t bytes = 0, msStart = clockMs();
+  while (client.connected() && clockMs() - msStart < PROBE_SECONDS * 1000)
+  {
+    int n = client.read(buf, sizeof(buf));
+    if (n > 0) bytes += n;
+    else clockSleep(1);
+  }
+  uint32_t ms = clockMs() - msStart;
+  client.stop();
+  return ms ? (uint64_t)bytes * 8 / ms : 0;
+}
+
+
+/**
+ * The driver only reports the bandwidth the station is configured 
+ * for. 40 MHz is possible if the AP uses a secondary channel as well.
+ */
+static void printLink()
+{
+  wifi_ap_record_t ap;
+  wifi_bandwidth_t bw = WIFI_BW_HT20;
+  if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK) return;
+  esp_wifi_get_bandwidth(WIFI_IF_STA, &bw);
+  bool ht40 = bw == WIFI_BW_HT40 && ap.phy_11n && ap.second != WIFI_SECOND_CHAN_NONE;
+  Serial.printf("  %-28s %d dBm, channel %u\r\n", "signal", ap.rssi, ap.primary);
+  Serial.printf("  %-28s 802.11%s%s%s\r\n", "phy", ap.phy_11b ? "b" : "", ap.phy_11g ? "g" : "", ap.phy_11n ? "n" : "");
+  Serial.printf("  %-28s %s\r\n", "channel width", ht40 ? "40 MHz possible, AP and station allow it" :
+                bw == WIFI_BW_HT40 ? "20 MHz, the AP has no secondary channel" : "20 MHz, the station is set to HT20");
+}
+
+
+/**
+ * Compare the link with the needs of the current station. The buffer
+ * refills at the difference of link throughput and station bitrate.
+ */
+static void probe(const char *hostPort)
+{
+  char host[64];
+  strlcpy(host, hostPort, sizeof(host));
+  char *colon = strchr(host, ':');
+  uint16_t port = colon ? atoi(colon + 1) : 5001;
+  if (colon) *colon = '\0';
+
+  IPAddress ip;
+  Serial.printf("\r\nNetwork probe %s:%u\r\n", host, port);
+  if (!WiFi.hostByName(host, ip)) { Serial.printf("  unknown host\r\n"); return; }
+  printLink();
+
+  int32_t rexmitBefore = retransmissions();
+  int32_t rtt = measureRtt(ip, port);
+  if (rtt < 0) { Serial.printf("  no connection\r\n"); return; }
+  uint32_t kbps = measureThroughput(ip, port);
+  int32_t rexmit = rexmitBefore < 0 ? -1 : retransmissions() - rexmitBefore;
+  metricSet(PROBE_RTT_MS, rtt);
+  metricSet(PROBE_KBPS, kbps);
+
+  uint32_t bitrate = audioBitRate() / 1000;
+  uint32_t bufferBytes = audioBufferBytes();
+
+  Serial.printf("  %-28s %10d ms\r\n", "rtt", rtt);
+  Serial.printf("  %-28s %10u kbit/s\r\n", "throughput", kbps);
+  if (rexmit >= 0) Serial.printf("  %-28s %10d\r\n", "tcp retransmissions", rexmit);
+  if (bitrate == 0) { Serial.printf("  no station playing\r\n"); return; }
+
+  Serial.printf("  %-28s %10u kbit/s\r\n", "station bitrate", bitrate);
+  Serial.printf("  %-28s %10u %%\r\n", "throughput of bitrate", kbps * 100 / bitrate);
+  Serial.printf("  %-28s %10u ms\r\n", "buffer", bufferBytes * 8 / bitrate);
+  if (kbps > bitrate) Serial.printf("  %-28s %10u ms\r\n", "buffer refill", bufferBytes * 8 / (kbps - bitrate));
+  else                Serial.printf("  the link cannot sustain the station, expect dropouts\r\n");
+}
+
+
+static void probeTaskFunc(void *)
+{
+  while (true)
+  {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    probe(server);
+    busy = false;
+  }
+}
+
+
+/**
+ * Set the test server as host:port, e.g. from the web API. 
+ * Returns false if it does not fit.
+ */
+bool setProbeServer(const char *hostPort)
+{
+  if (*hostPort == '\0' || strlen(hostPort) >= sizeof(probeServer)) return false;
+  strlcpy(probeServer, hostPort, sizeof(probeServer));
+  return true;
+}
+
+
+/**
+ * Start the probe against the test server in the background, the 
+ * server sends data as fast as it can, e.g.
+ *   socat TCP-LISTEN:5001,fork,reuseaddr OPEN:/dev/zero
+ * The task owns its copy of the server until the probe is done.
+ */
+void networkProbe(const char *txt)
+{
+  if (busy) { Serial.printf("\r\nNetwork probe still running\r\n"); return; }
+  if (probeTask == nullptr) xTaskCreatePinnedToCore(probeTaskFunc, "netProbe", 4096, NULL, tskIDLE_PRIORITY + 1, &probeTask, 0);
+  strlcpy(server, probeServer, sizeof(server));
+  busy = true;
+  xTaskNotifyGive(probeTask);
+}
@@ -0,0 +1,55 @@
+#include <Arduino.h>
+#include "httpPool.h"
+#include "playlist.h"
+
+#define PLAYLIST_MAX 1024  // bytes of a playlist which are examined
+
+static bool endsWith(const char *s, const char *suffix)
+{
+  size_t n = strlen(s), m = strlen(suffix);
+  return n >= m && strcasecmp(s + n - m, suffix) == 0;
+}
+
+
+/**
+ * Copy the first stream url of an m3u or pls playlist into url
+ */
+bool parsePlaylist(const char *body, char *url, size_t size)
+{
+  for (const char *line = body; *line; )
+  {
+    size_t lineLen = strcspn(line, "\r\n");
+    size_t len = lineLen;
+    const char *p = line;
+    if (strncasecmp(p, "File", 4) == 0)                   // pls: File1=http://...
+    {
+      const char *eq = (const char *)memchr(p, '=', len);
+      if (eq) { len -= eq + 1 - p; p = eq + 1; }
+    }
+    if (len < size && (strncmp(p, "http://", 7) == 0 || strncmp(p, "https://", 8) == 0))
+    {
+      memcpy(url, p, len);
+      url[len] = '\0';
+      return true;
+    }
+    line += lineLen;
+    line += strspn(line, "\r\n");
+  }
+  return false;
+}
+
+
+/**
+ * Resolve .m3u and .pls urls to the stream url they contain, using 
+ * a pooled connection. Other urls and failed lookups are returned 
+ * unchanged. The result is valid until the next call.
+ */
+const char *resolvePlaylist(const char *url)
+{
+  static char body[PLAYLIST_MAX];
+  static char streamUrl[256];
+
+  if (! endsWith(url, ".m3u") && ! endsWith(url, ".pls")) return url;
+  if (httpFetch(url, body, sizeof(body)) != 200) return url;
+  return parsePlaylist(body, streamUrl, sizeof(streamUrl)) ? streamUrl : url;
+}
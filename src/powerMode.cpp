@@ -0,0 +1,44 @@
+#include <Arduino.h>
+#include <Wire.h>
+#include "metrics.h"
+#include "powerMode.h"
+
+#define CPU_MHZ_FULL      240
+#define CPU_MHZ_LOW_POWER 160   // still enough for 128 kbit/s MP3, WiFi needs >= 80
+
+// INA219 in the supply line, on the I2C bus of the display
+#define INA219_ADDRESS    0x40
+#define INA219_SHUNT_REG  0x01    // shunt voltage, 10 uV per bit
+#define SHUNT_MILLIOHM    100     // the shunt of the common breakout boards
+#define SENSOR_SDA        GPIO_NUM_21
+#define SENSOR_SCL        GPIO_NUM_22
+#define I2C_CLOCK         400000
+
+/**
+ * Switch the CPU clock for full quality or low power playback.
+ * The audio library decodes and synthesizes the full bandwidth
+ * in either case, the low power mode only removes the headroom.
+ */
+void applyPowerMode(bool lowPower)
+{
+  uint32_t mhz = lowPower ? CPU_MHZ_LOW_POWER : CPU_MHZ_FULL;
+  if (getCpuFrequencyMhz() != mhz) setCpuFrequencyMhz(mhz);
+  metricSet(CPU_MHZ, getCpuFrequencyMhz());
+}
+
+
+/**
+ * Supply current of the board in mA, measured by an INA219 in its 
+ * power-on configuration. Returns -1 if no sensor answers.
+ */
+int32_t supplyCurrentMa()
+{
+  static bool started = false;
+  if (!started) started = Wire.begin(SENSOR_SDA, SENSOR_SCL, I2C_CLOCK);
+  Wire.beginTransmission(INA219_ADDRESS);
+  Wire.write(INA219_SHUNT_REG);
+  if (Wire.endTransmission() != 0 || Wire.requestFrom(INA219_ADDRESS, 2) != 2) return -1;
+  int16_t raw = Wire.read() << 8;
+  raw |= Wire.read();
+  return (int32_t)raw * 10 / SHUNT_MILLIOHM;   // uV / mOhm = mA
+}
@@ -0,0 +1,102 @@
+#include <Arduino.h>
+#include <lwip/sockets.h>
+#include <WiFi.h>
+#include "httpPool.h"
+#include "metrics.h"
+#include "clock.h"
+#include "audioTask.h"
+#include "prebufferReport.h"
+
+#define PREBUFFER_PERCENT 80    // buffer fill which ends the pre-buffering phase
+#define STEADY_BDP_FACTOR 2     // steady state window in bandwidth delay products
+#define MIN_WINDOW        (2 * TCP_MSS)
+#define MAX_WINDOW        TCP_WND
+
+static const char * volatile rttUrl = nullptr;
+static volatile uint32_t rttMs      = 0;
+static volatile bool rttDone        = false;   // measured or failed
+static TaskHandle_t rttTask         = nullptr;
+static uint32_t msStreamStart       = 0;
+static bool     prebuffering        = false;
+
+
+/**
+ * Receive window for a stream of kbps measured with the given RTT.
+ * While pre-buffering the socket may use the whole lwIP window, in 
+ * steady state a few bandwidth delay products suffice.
+ */
+static int rcvWindowFor(uint32_t kbps, uint32_t rtt, bool prebuffer)
+{
+  if (prebuffer || kbps == 0 || rtt == 0) return MAX_WINDOW;
+  uint32_t bdp = kbps * 1000 / 8 * rtt / 1000;
+  return constrain(STEADY_BDP_FACTOR * bdp, MIN_WINDOW, MAX_WINDOW);
+}
+
+
+/**
+ * Measure the RTT to the stream host as the duration of a TCP 
+ * connect to its already resolved address, 0 if it failed
+ */
+static void rttTaskFunc(void *)
+{
+  char host[64];
+  const char *path;
+  uint16_t port;
+  bool tls;
+
+  while (true)
+  {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    const char *url = rttUrl;
+    IPAddress ip;
+    if (url && splitUrl(url, tls, host, sizeof(host), port, path) && WiFi.hostByName(host, ip))
+    {
+      WiFiClient client;
+      uint32_t msStart = clockMs();
+      if (client.connect(ip, port, 2000)) rttMs = clockMs() - msStart;
+      client.stop();
+    }
+    metricSet(STREAM_RTT_MS, rttMs);
+    rttDone = true;
+  }
+}
+
+
+void initPrebufferReport()
+{
+  xTaskCreatePinnedToCore(rttTaskFunc, "rttProbe", 4096, NULL, tskIDLE_PRIORITY + 1, &rttTask, 0);
+}
+
+
+/**
+ * A new stream starts pre-buffering, measure its RTT in the background
+ */
+void streamStarted(const char *url)
+{
+  msStreamStart = clockMs();
+  prebuffering  = true;
+  rttUrl  = url;
+  rttMs   = 0;
+  rttDone = false;
+  if (rttTask) xTaskNotifyGive(rttTask);
+}
+
+
+/**
+ * Track the pre-buffering and report the fill time and the receive 
+ * window the stream would need in steady state. Nothing is sized from 
+ * it: lwIP only honours SO_RCVBUF for UDP, a TCP socket advertises a 
+ * window which shrinks by what the reader leaves unread, and the audio 
+ * library reads its socket and sizes its buffer itself.
+ */
+void prebufferPoll()
+{
+  if (!prebuffering) return;
+  if (!audioRunning() || audioFillPercent() < PREBUFFER_PERCENT) return;
+  if (!rttDone || audioBitRate() == 0) return;  // wait for the RTT and the bitrate
+
+  prebuffering = false;
+  metricSet(PREBUFFER_FILL_MS, clockMs() - msStreamStart);
+  metricSet(RCV_WINDOW_STEADY, rttMs ? rcvWindowFor(audioBitRate() / 1000, rttMs, false) : 0);
+}
+
@@ -0,0 +1,167 @@
+#include <Arduino.h>
+#include "readAheadFS.h"
+#include "memPolicy.h"
+
+using namespace fs;
+
+/**
+ * File implementation with a chunk buffer in front of the
+ * underlying file. The buffer always holds the chunk which
+ * starts at bufStart, bufLen bytes of it are valid.
+ */
+class ReadAheadFileImpl : public FileImpl
+{
+  public:
+    ReadAheadFileImpl(File file, size_t chunkSize) : 
+      _file(file), _chunkSize(chunkSize) 
+    {
+      if (_file && !_file.isDirectory()) _buf = (uint8_t *)memAlloc(MEM_READ_AHEAD, _chunkSize);
+    }
+
+    ~ReadAheadFileImpl() { close(); }
+
+    size_t read(uint8_t *buf, size_t size) override
+    {
+      if (!_file) return 0;
+      if (!_buf) return readThrough(buf, size);
+
+      size_t done = 0;
+      while (done < size)
+      {
+        // serve what we have in the buffer
+        if (_pos >= _bufStart && _pos < _bufStart + _bufLen)
+        {
+          size_t n = std::min(size - done, (size_t)(_bufStart + _bufLen - _pos));
+          memcpy(buf + done, _buf + (_pos - _bufStart), n);
+          done += n;
+          _pos += n;
+          continue;
+        }
+        if (_pos >= _file.size()) break;
+
+        // large reads on a chunk boundary go directly to the caller
+        if (_pos % _chunkSize == 0 && size - done >= _chunkSize)
+        {
+          size_t n = (size - done) / _chunkSize * _chunkSize;
+          n = readThrough(buf + done, n);
+          done += n;
+          if (n == 0) break;
+          continue;
+        }
+
+        // refill the buffer with the aligned chunk containing _pos
+        uint32_t start = _pos - _pos % _chunkSize;
+        if (_filePos != start && !_file.seek(start, SeekSet)) break;
+        _bufStart = start;
+        _bufLen   = _file.read(_buf, _chunkSize);
+        _filePos  = start + _bufLen;
+        if (_bufLen == 0) break;
+      }
+      return done;
+    }
+
+    bool seek(uint32_t pos, SeekMode mode) override
+    {
+      int64_t target;
+      switch (mode)
+      {
+        case SeekCur: target = (int64_t)_pos + pos; break;
+        case SeekEnd: target = (int64_t)_file.size() + pos; break;
+        default:      target = pos; break;
+      }
+      if (target < 0 || target > (int64_t)_file.size()) return false;
+      _pos = (uint32_t)target;
+      return true;
+    }
+
+    size_t write(const uint8_t *buf, size_t size) override
+    {
+      _bufLen = 0;  // invalidate read-ahead
+      if (_filePos != _pos) _file.seek(_pos, SeekSet);
+      size_t n = _file.write(buf, size);
+      _pos += n;
+      _filePos = _pos;
+      return n;
+    }
+
+    void flush() override                        { _file.flush(); }
+    size_t position() const override             { return _pos; }
+    size_t size() const override                 { return _file.size(); }
+    bool setBufferSize(size_t size) override     { return _file.setBufferSize(size); }
+    time_t getLastWrite() override               { return _file.getLastWrite(); }
+    const char *path() const override            { return _file.path(); }
+    const char *name() const override            { return _file.name(); }
+    boolean isDirectory(void) override           { return _file.isDirectory(); }
+    void rewindDirectory(void) override          { _file.rewindDirectory(); }
+    operator bool() override                     { return (bool)_file; }
+
+    FileImplPtr openNextFile(const char *mode) override
+    {
+      File next = _file.openNextFile(mode);
+      return next ? std::make_shared<ReadAheadFileImpl>(next, _chunkSize) : FileImplPtr();
+    }
+
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+    boolean seekDir(long position) override      { return _file.seekDir(position); }
+    String getNextFileName(void) override        { return _file.getNextFileName(); }
+    String getNextFileName(bool *isDir) override { return _file.getNextFileName(isDir); }
+#endif
+
+    void close() override
+    {
+      if (_file) _file.close();
+      free(_buf);
+      _buf = nullptr;
+      _bufLen = 0;
+    }
+
+  private:
+    size_t readThrough(uint8_t *buf, size_t size)
+    {
+      if (_filePos != _pos && !_file.seek(_pos, SeekSet)) return 0;
+      size_t n = _file.read(buf, size);
+      _pos += n;
+      _filePos = _pos;
+      return n;
+    }
+
+    File     _file;
+    size_t   _chunkSize;
+    uint8_t *_buf      = nullptr;
+    uint32_t _bufStart = 0;   // file offset of the buffered chunk
+    size_t   _bufLen   = 0;   // valid bytes in the buffer
+    uint32_t _pos      = 0;   // logical position seen by the caller
+    uint32_t _filePos  = 0;   // position of the underlying file
+};
+
+
+/**
+ * FS implementation which delegates everything to the base 
+ * file system and wraps the opened files
+ */
+class ReadAheadFSImpl : public FSImpl
+{
+  public:
+    ReadAheadFSImpl(FS &base, size_t chunkSize) : _base(base), _chunkSize(chunkSize) {}
+
+    FileImplPtr open(const char *path, const char *mode, const bool create) override
+    {
+      File f = _base.open(path, mode, create);
+      return f ? std::make_shared<ReadAheadFileImpl>(f, _chunkSize) : FileImplPtr();
+    }
+
+    bool exists(const char *path) override                      { return _base.exists(path); }
+    bool rename(const char *pathFrom, const char *pathTo) override { return _base.rename(pathFrom, pathTo); }
+    bool remove(const char *path) override                      { return _base.remove(path); }
+    bool mkdir(const char *path) override                       { return _base.mkdir(path); }
+    bool rmdir(const char *path) override                       { return _base.rmdir(path); }
+
+  private:
+    FS    &_base;
+    size_t _chunkSize;
+};
+
+
+ReadAheadFS::ReadAheadFS(fs::FS &base, size_t chunkSize) : 
+  FS(std::make_shared<ReadAheadFSImpl>(base, chunkSize))
+{}
@@ -0,0 +1,196 @@
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <HTTPClient.h>
+#include <WiFiClientSecure.h>
+#include "metrics.h"
+#include "clock.h"
+#include "memPolicy.h"
+#include "audioTask.h"
+#include "recorder.h"
+
+#define REC_DIR            "/rec"
+#define REC_RATE_LIMIT     24576  // bytes per second, 1.5 times a 128 kbit/s stream
+#define REC_SAFETY_PERCENT 60     // pause while the playing stream buffer is below
+#define REC_FLASH_RESERVE  65536  // bytes kept free on LittleFS
+#define REC_WRITE_BLOCK    4096   // flash is written in whole blocks
+#define REC_STALL_BUDGET_MS 40    // an erase stalls the flash cache of both cores, the I2S DMA buffers must cover it
+#define REC_TASK_PRIORITY  (tskIDLE_PRIORITY + 1)
+#define REC_TASK_STACK     12288  // room for a TLS handshake of an https stream
+
+static volatile bool recording = false;
+static TaskHandle_t recTask = nullptr;
+static char recUrl[256];
+static char recPath[32];     // the recording being written
+static char lastPath[32];    // the last complete one
+
+
+/**
+ * Hold the recorder back while the playing stream needs the
+ * bandwidth and keep it below REC_RATE_LIMIT. Returns the ms
+ * spent waiting for the playing stream.
+ */
+static uint32_t throttle(uint32_t bytesSoFar, uint32_t msStart)
+{
+  uint32_t msWaited = 0;
+  while (recording && audioRunning() && audioFillPercent() < REC_SAFETY_PERCENT)
+  {
+    clockSleep(100);
+    msWaited += 100;
+  }
+  uint32_t msEarliest = msStart + (uint64_t)bytesSoFar * 1000 / REC_RATE_LIMIT;
+  int32_t msAhead = (int32_t)(msEarliest - clockMs());
+  if (msAhead > 0) clockSleep(msAhead);
+  return msWaited;
+}
+
+
+/**
+ * Write a block to flash and account the time, which 
+ * includes the erase of a sector when LittleFS needs one
+ */
+static void writeBlock(File &f, const uint8_t *block, size_t len)
+{
+  uint32_t ms = clockMs();
+  f.write(block, len);
+  ms = clockMs() - ms;
+  if (ms > (uint32_t)metricGet(REC_WRITE_MAX_MS)) metricSet(REC_WRITE_MAX_MS, ms);
+  if (ms > REC_STALL_BUDGET_MS) metricAdd(REC_SLOW_WRITES);
+}
+
+
+/**
+ * Receive the compressed stream and write it to flash unchanged, 
+ * until stopped or the flash budget is used up. Returns the bytes.
+ */
+static uint32_t recordStream(File &f)
+{
+  HTTPClient http;
+  WiFiClient plain;
+  WiFiClientSecure secure;
+  secure.setInsecure();
+  WiFiClient &client = strncmp(recUrl, "https:", 6) == 0 ? secure : plain;
+  http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
+  if (!http.begin(client, recUrl)) return 0;
+  int code = http.GET();
+  metricAdd(HTTP_REQUESTS);
+  if (code != HTTP_CODE_OK)
+  {
+    log_w("Recording failed: %d", code);
+    http.end();
+    return 0;
+  }
+
+  // the recorder reads slowly, so lwIP closes its receive window and the playing stream keeps the bandwidth
+  WiFiClient *stream = http.getStreamPtr();
+
+  uint8_t *block = (uint8_t *)memAlloc(MEM_RECORDER, REC_WRITE_BLOCK);
+  if (!block)
+  {
+    log_w("No memory for the recorder block");
+    http.end();
+    return 0;
+  }
+  size_t filled = 0;
+  uint32_t budget = LittleFS.totalBytes() - LittleFS.usedBytes();
+  budget = budget > REC_FLASH_RESERVE ? budget - REC_FLASH_RESERVE : 0;
+  uint32_t msStart = clockMs(), bytes = 0;
+
+  while (recording && http.connected() && bytes + REC_WRITE_BLOCK <= budget)
+  {
+    uint32_t msWaited = throttle(bytes, msStart);
+    if (msWaited)
+    {
+      metricAdd(REC_THROTTLE_EVENTS);
+      metricAdd(REC_THROTTLED_MS, msWaited);
+    }
+    size_t avail = stream->available();
+    if (avail == 0) { clockSleep(10); continue; }
+    int len = stream->read(block + filled, std::min<size_t>(avail, REC_WRITE_BLOCK - filled));
+    if (len <= 0) break;
+    filled += len;
+    bytes += len;
+    if (filled == REC_WRITE_BLOCK) { writeBlock(f, block, filled); filled = 0; }
+    metricSet(REC_BYTES, bytes);
+  }
+  if (filled) writeBlock(f, block, filled);
+  free(block);
+  http.end();
+
+  uint32_t ms = clockMs() - msStart;
+  Serial.printf("\r\nRecorded %u KB in %u s to %s%s\r\n", bytes >> 10, ms / 1000, recPath,
+                bytes + REC_WRITE_BLOCK > budget ? ", flash budget used up" : "");
+  Serial.printf("  held back %u times for %u ms in total\r\n", metricGet(REC_THROTTLE_EVENTS), metricGet(REC_THROTTLED_MS));
+  Serial.printf("  longest flash write %u ms, %u writes over the budget of %u ms\r\n",
+                metricGet(REC_WRITE_MAX_MS), metricGet(REC_SLOW_WRITES), REC_STALL_BUDGET_MS);
+  return bytes;
+}
+
+
+/**
+ * The recording becomes the last one once it is closed, 
+ * an empty file is removed
+ */
+static void recTaskFunc(void *)
+{
+  File f = LittleFS.open(recPath, FILE_WRITE);
+  if (!f) log_w("Cannot create %s", recPath);
+  else
+  {
+    uint32_t bytes = recordStream(f);
+    f.close();
+    if (bytes) strlcpy(lastPath, recPath, sizeof(lastPath));
+    else       LittleFS.remove(recPath);
+  }
+  recording = false;
+  recTask = nullptr;
+  vTaskDelete(NULL);
+}
+
+
+/**
+ * Start recording the url to /rec/<date-time>.mp3 in the background, 
+ * or stop a running recording. A name which exists already, e.g. 
+ * before the clock is set, gets a number appended.
+ */
+void toggleRecording(const char *url)
+{
+  if (recording)
+  {
+    recording = false;
+    return;
+  }
+  if (recTask) return;   // still finishing
+
+  struct tm tm;
+  time_t now = clockTime();
+  localtime_r(&now, &tm);
+  char name[16];
+  strftime(name, sizeof(name), "%m%d-%H%M%S", &tm);
+  snprintf(recPath, sizeof(recPath), REC_DIR "/%s.mp3", name);
+  for (int n = 2; LittleFS.exists(recPath); n++) snprintf(recPath, sizeof(recPath), REC_DIR "/%s-%d.mp3", name, n);
+  strlcpy(recUrl, url, sizeof(recUrl));
+  LittleFS.mkdir(REC_DIR);
+  metricSet(REC_BYTES, 0);
+  metricSet(REC_THROTTLE_EVENTS, 0);
+  metricSet(REC_THROTTLED_MS, 0);
+  metricSet(REC_WRITE_MAX_MS, 0);
+  metricSet(REC_SLOW_WRITES, 0);
+
+  recording = true;
+  if (xTaskCreatePinnedToCore(recTaskFunc, "recorder", REC_TASK_STACK, NULL, REC_TASK_PRIORITY, &recTask, 0) != pdPASS)
+  {
+    recording = false;
+    log_w("Recorder task not started");
+    return;
+  }
+  Serial.printf("Recording to %s\r\n", recPath);
+}
+
+
+/**
+ * Path of the last complete recording, empty if there is none
+ */
+const char *lastRecording()
+{
+  return lastPath;
+}
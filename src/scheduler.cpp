@@ -0,0 +1,264 @@
+#include <Arduino.h>
+#include "scheduler.h"
+#include "metrics.h"
+#include "clock.h"
+
+#define TICK_MS           10
+#define L0_BITS           8       // 256 ticks = 2.56 s
+#define LN_BITS           6       // 64 slots on each higher level
+#define L0_SIZE           (1 << L0_BITS)
+#define LN_SIZE           (1 << LN_BITS)
+#define L1_SPAN           (1u << (L0_BITS + LN_BITS))       // 164 s
+#define L2_SPAN           (1u << (L0_BITS + 2 * LN_BITS))   // 2.9 h
+#define MAX_TIMERS        16
+#define SCHED_TASK_PRIORITY (tskIDLE_PRIORITY + 2)
+
+struct Timer
+{
+  const char *name;
+  JobFn fn;
+  void *ctx;
+  uint32_t expires;       // tick
+  uint32_t period;        // ticks, 0 for a one shot
+  JobPriority prio;
+  int8_t next;            // next timer in the same slot
+  bool active;
+  uint32_t runs, usTotal, usMax, late;
+};
+
+static Timer timers[MAX_TIMERS];
+static int8_t level0[L0_SIZE], level1[LN_SIZE], level2[LN_SIZE];
+static uint32_t used0[L0_SIZE / 32];   // non-empty slots of level 0
+static uint32_t wheelTick;             // next tick to expire
+static int8_t queue[JOB_PRIORITIES][MAX_TIMERS];
+static uint8_t queueHead[JOB_PRIORITIES], queueCount[JOB_PRIORITIES];
+static portMUX_TYPE wheelMux = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t schedTask = nullptr;
+static bool initialized = false;
+
+
+static uint32_t nowTick() { return clockMs() / TICK_MS; }
+
+
+/**
+ * Put a timer into the slot of its level, the level
+ * follows from the distance to its expiry
+ */
+static void link(int8_t i)
+{
+  Timer &t = timers[i];
+  if ((int32_t)(t.expires - wheelTick) < 0) t.expires = wheelTick;
+  uint32_t delta = t.expires - wheelTick;
+  int8_t *slot;
+  if (delta < L0_SIZE)
+  {
+    uint8_t s = t.expires & (L0_SIZE - 1);
+    used0[s / 32] |= 1u << (s % 32);
+    slot = &level0[s];
+  }
+  else if (delta < L1_SPAN) slot = &level1[(t.expires >> L0_BITS) & (LN_SIZE - 1)];
+  else
+  {
+    // beyond the wheel: park in the last slot, it is linked again when cascaded
+    uint32_t at = delta < L2_SPAN ? t.expires : wheelTick + L2_SPAN - 1;
+    slot = &level2[(at >> (L0_BITS + LN_BITS)) & (LN_SIZE - 1)];
+  }
+  t.next = *slot;
+  *slot = i;
+}
+
+
+/**
+ * Move the timers of a higher level slot down,
+ * once the wheel reaches their range
+ */
+static void cascade(int8_t *slot)
+{
+  int8_t i = *slot;
+  *slot = -1;
+  while (i >= 0)
+  {
+    int8_t next = timers[i].next;
+    link(i);
+    i = next;
+  }
+}
+
+
+static void enqueue(int8_t i)
+{
+  JobPriority p = timers[i].prio;
+  if (queueCount[p] == MAX_TIMERS) return;
+  queue[p][(queueHead[p] + queueCount[p]++) % MAX_TIMERS] = i;
+}
+
+
+static int8_t dequeue()
+{
+  for (uint8_t p = 0; p < JOB_PRIORITIES; p++)
+  {
+    if (queueCount[p] == 0) continue;
+    int8_t i = queue[p][queueHead[p]];
+    queueHead[p] = (queueHead[p] + 1) % MAX_TIMERS;
+    queueCount[p]--;
+    return i;
+  }
+  return -1;
+}
+
+
+/**
+ * Next non-empty level 0 slot from s on, L0_SIZE if none
+ */
+static uint32_t nextUsed(uint32_t s)
+{
+  while (s < L0_SIZE)
+  {
+    uint32_t bits = used0[s / 32] >> (s % 32);
+    if (bits) return s + __builtin_ctz(bits);
+    s = (s / 32 + 1) * 32;
+  }
+  return L0_SIZE;
+}
+
+
+/**
+ * Expire all timers up to tick now into the job queue. Empty
+ * slots are skipped with the bitmap, so the wheel only stops
+ * at slots with timers and at the turns of level 0.
+ */
+static void advance(uint32_t now)
+{
+  while ((int32_t)(now - wheelTick) >= 0)
+  {
+    uint32_t s = wheelTick & (L0_SIZE - 1);
+    if (s == 0)
+    {
+      uint32_t s1 = (wheelTick >> L0_BITS) & (LN_SIZE - 1);
+      if (s1 == 0) cascade(&level2[(wheelTick >> (L0_BITS + LN_BITS)) & (LN_SIZE - 1)]);
+      cascade(&level1[s1]);
+    }
+    if (level0[s] >= 0)
+    {
+      for (int8_t i = level0[s]; i >= 0; i = timers[i].next) enqueue(i);
+      level0[s] = -1;
+      used0[s / 32] &= ~(1u << (s % 32));
+    }
+    uint32_t step = nextUsed(s + 1) - s;
+    wheelTick += std::min<uint32_t>(step, now + 1 - wheelTick);
+  }
+}
+
+
+static void init()
+{
+  memset(level0, -1, sizeof(level0));
+  memset(level1, -1, sizeof(level1));
+  memset(level2, -1, sizeof(level2));
+  wheelTick = nowTick();
+  initialized = true;
+}
+
+
+/**
+ * Run fn with the priority after firstMs and then every periodMs,
+ * or once if periodMs is 0. Returns -1 if all timers are in use.
+ */
+int addTimer(const char *name, uint32_t firstMs, uint32_t periodMs, JobPriority prio, JobFn fn, void *ctx)
+{
+  int8_t i = -1;
+  portENTER_CRITICAL(&wheelMux);
+  if (!initialized) init();
+  advance(nowTick());
+  for (int8_t k = 0; k < MAX_TIMERS && i < 0; k++) if (!timers[k].active) i = k;
+  if (i >= 0)
+  {
+    timers[i] = { name, fn, ctx, wheelTick - 1 + (firstMs + TICK_MS - 1) / TICK_MS,
+                  (periodMs + TICK_MS - 1) / TICK_MS, prio, -1, true, 0, 0, 0, 0 };
+    link(i);
+  }
+  portEXIT_CRITICAL(&wheelMux);
+  if (schedTask) xTaskNotifyGive(schedTask);
+  return i;
+}
+
+
+/**
+ * Run the due jobs and return the ms until the next timer expires.
+ * The scheduler task sleeps that long, the host test moves the 
+ * virtual clock on by it.
+ */
+uint32_t runDueJobs()
+{
+  while (true)
+  {
+    portENTER_CRITICAL(&wheelMux);
+    advance(nowTick());
+    int8_t i = dequeue();
+    uint32_t wake = (wheelTick & ~(L0_SIZE - 1)) + nextUsed(wheelTick & (L0_SIZE - 1));
+    portEXIT_CRITICAL(&wheelMux);
+
+    if (i < 0)
+    {
+      int32_t ticks = (int32_t)(wake - nowTick());
+      if (ticks > 0) return ticks * TICK_MS;
+      continue;
+    }
+
+    Timer &t = timers[i];
+    uint32_t us = micros();
+    t.fn(t.ctx);
+    us = micros() - us;
+
+    portENTER_CRITICAL(&wheelMux);
+    t.runs++;
+    t.usTotal += us;
+    t.usMax = std::max(t.usMax, us);
+    if (t.period == 0) t.active = false;
+    else
+    {
+      advance(nowTick());
+      t.expires += t.period;
+      if ((int32_t)(t.expires - wheelTick) < 0) { t.late++; t.expires = wheelTick - 1 + t.period; }
+      link(i);
+    }
+    portEXIT_CRITICAL(&wheelMux);
+  }
+}
+
+
+/**
+ * Sleep until the next timer expires or a new one is added
+ */
+static void schedTaskFunc(void *)
+{
+  while (true)
+  {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(runDueJobs()));
+    metricAdd(SCHED_WAKEUPS);
+  }
+}
+
+
+void startScheduler()
+{
+  portENTER_CRITICAL(&wheelMux);
+  if (!initialized) init();
+  portEXIT_CRITICAL(&wheelMux);
+  xTaskCreatePinnedToCore(schedTaskFunc, "scheduler", 8192, NULL, SCHED_TASK_PRIORITY, &schedTask, 0);
+}
+
+
+/**
+ * Print the jobs with their runs and runtimes
+ */
+void showJobs(const char *txt)
+{
+  Serial.printf("\r\nJobs:                      period ms   runs   avg us   max us  late\r\n");
+  for (auto &t : timers)
+  {
+    if (!t.active) continue;
+    Serial.printf("  %-24s %9u %6u %8u %8u %5u\r\n", t.name, t.period * TICK_MS, t.runs,
+                  t.runs ? t.usTotal / t.runs : 0, t.usMax, t.late);
+  }
+}
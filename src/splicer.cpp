@@ -0,0 +1,354 @@
+#include <Arduino.h>
+#include "splicer.h"
+#include "mp3Sync.h"
+
+static uint32_t frameHash(const uint8_t *p, size_t len)
+{
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i < len; i++) h = (h ^ p[i]) * 16777619u;
+  return h;
+}
+
+
+void MirrorQueue::begin(uint8_t *ring, size_t ringSize)
+{
+  _ring = ring;
+  _ringSize = ringSize;
+  reset();
+}
+
+
+void MirrorQueue::reset()
+{
+  _rawLen = _ringHead = _ringUsed = 0;
+  _first = _count = 0;
+  _synced = _everSynced = false;
+  _gap = true;
+}
+
+
+/**
+ * Drop the bytes of a frame which is not complete, e.g. when the
+ * path reconnects. The next frame is marked to follow a gap.
+ */
+void MirrorQueue::cut()
+{
+  _rawLen = 0;
+  _synced = false;
+  _gap = true;
+}
+
+
+/**
+ * Take bytes as they arrive, at most space() of them
+ */
+void MirrorQueue::append(const uint8_t *buf, size_t len)
+{
+  len = std::min(len, space());
+  memcpy(_raw + _rawLen, buf, len);
+  _rawLen += len;
+  parse();
+}
+
+
+/**
+ * Cut the received bytes into frames. A frame is queued once the header
+ * after it is valid and consistent, otherwise the sync is lost and found
+ * again with a chain of headers. Frames wait in _raw while the queue is
+ * full, so the receiver stops reading and TCP holds the sender back.
+ */
+void MirrorQueue::parse()
+{
+  size_t pos = 0;
+  while (true)
+  {
+    if (!_synced)
+    {
+      int32_t k = mp3FindSync(_raw + pos, _rawLen - pos);
+      if (k < 0)
+      {
+        // keep enough to find a chain which is not complete yet
+        size_t keep = SYNC_CHAIN * FRAME_MAX_LEN;
+        if (_rawLen - pos > keep)
+        {
+          skippedBytes += _rawLen - pos - keep;
+          lastSkipped  += _rawLen - pos - keep;
+          pos = _rawLen - keep;
+        }
+        break;
+      }
+      skippedBytes += k;
+      lastSkipped  += k;
+      pos += k;
+      if (_everSynced) resyncs++;
+      _synced = _everSynced = true;
+    }
+
+    Mp3Header h, next;
+    if (_rawLen - pos < 4) break;
+    if (!parseMp3Header(_raw + pos, h)) { _synced = false; _gap = true; lastSkipped = 0; continue; }
+    if (_rawLen - pos < h.frameLen + 4u) break;    // the frame and the next header
+    if (!parseMp3Header(_raw + pos + h.frameLen, next) || next.version != h.version || next.sampleRate != h.sampleRate)
+    {
+      // the frame or the next header is damaged, search from the next byte
+      pos++;
+      skippedBytes++;
+      _synced = false;
+      _gap = true;
+      lastSkipped = 1;
+      continue;
+    }
+    if (!push(_raw + pos, h.frameLen)) break;
+    pos += h.frameLen;
+  }
+  memmove(_raw, _raw + pos, _rawLen - pos);
+  _rawLen -= pos;
+}
+
+
+bool MirrorQueue::push(const uint8_t *p, uint16_t len)
+{
+  if (_count == QUEUE_FRAMES || _ringSize - _ringUsed < len) return false;
+  size_t at = (_ringHead + _ringUsed) % _ringSize;
+  size_t n = std::min<size_t>(len, _ringSize - at);
+  memcpy(_ring + at, p, n);
+  memcpy(_ring, p + n, len - n);
+  _ringUsed += len;
+  _frames[(_first + _count++) % QUEUE_FRAMES] = { frameHash(p, len), len, _gap };
+  _gap = false;
+  return true;
+}
+
+
+bool MirrorQueue::at(uint8_t k, SpliceFrame &f) const
+{
+  if (k >= _count) return false;
+  f = _frames[(_first + k) % QUEUE_FRAMES];
+  return true;
+}
+
+
+/**
+ * Remove the oldest frame and copy it to out, unless out is nullptr.
+ * Frames which waited for room are queued now.
+ */
+void MirrorQueue::pop(uint8_t *out)
+{
+  if (_count == 0) return;
+  uint16_t len = _frames[_first].len;
+  if (out)
+  {
+    size_t n = std::min<size_t>(len, _ringSize - _ringHead);
+    memcpy(out, _ring + _ringHead, n);
+    memcpy(out + n, _ring, len - n);
+  }
+  _ringHead = (_ringHead + len) % _ringSize;
+  _ringUsed -= len;
+  _first = (_first + 1) % QUEUE_FRAMES;
+  _count--;
+  parse();
+}
+
+
+void Splicer::reset()
+{
+  memset(frames, 0, sizeof(frames));
+  switches = jumps = 0;
+  _seq = 0;
+  memset(_inStep, 0, sizeof(_inStep));
+  _active = -1;
+  _waiting = false;
+}
+
+
+/**
+ * Find the queued frames of a path among the last frames given out. 
+ * Where the oldest one matches several of them, e.g. in silence, 
+ * the longest run of matching frames decides.
+ */
+void Splicer::align(uint8_t i)
+{
+  SpliceFrame f;
+  uint32_t oldest = _seq > HISTORY_FRAMES ? _seq - HISTORY_FRAMES : 0;
+  uint8_t best = 0;
+  for (uint32_t s = oldest; s < _seq; s++)
+  {
+    uint8_t k = 0;
+    while (s + k < _seq && _q[i]->at(k, f) && _history[(s + k) % HISTORY_FRAMES] == f.hash) k++;
+    if (k > 0 && k >= best)
+    {
+      best = k;
+      _headSeq[i] = s;
+    }
+  }
+  _inStep[i] = best > 0;
+}
+
+
+/**
+ * Drop the frames of a path in step which were given out already. 
+ * A frame which differs from the one given out, or which follows lost
+ * bytes where there is nothing to compare it with, puts it out of step.
+ */
+void Splicer::catchUp(uint8_t i)
+{
+  SpliceFrame f;
+  while (_q[i]->head(f))
+  {
+    bool given = _headSeq[i] < _seq;
+    bool known = given && _seq - _headSeq[i] <= HISTORY_FRAMES;
+    if (known ? _history[_headSeq[i] % HISTORY_FRAMES] != f.hash : f.gap)
+    {
+      _inStep[i] = false;
+      return;
+    }
+    if (!given) return;
+    _q[i]->pop(nullptr);
+    _headSeq[i]++;
+  }
+}
+
+
+/**
+ * Copy the next frame of the station to out and return its length,
+ * 0 if no path has it yet. The path of the last frame is preferred,
+ * the other one continues when it holds the next frame first.
+ */
+size_t Splicer::next(uint8_t *out, uint32_t msNow)
+{
+  SpliceFrame f;
+  for (uint8_t i = 0; i < MIRRORS; i++)
+  {
+    if (!_inStep[i] && _q[i]->head(f)) align(i);
+    if (_inStep[i]) catchUp(i);
+  }
+
+  int8_t pick = -1;
+  for (uint8_t k = 0; k < MIRRORS && pick < 0; k++)
+  {
+    uint8_t i = _active < 0 ? k : (_active + k) % MIRRORS;
+    if (_inStep[i] && _headSeq[i] == _seq && _q[i]->head(f)) pick = i;
+  }
+
+  // a path ahead of the stream, or with other content, keeps moving
+  for (uint8_t i = 0; i < MIRRORS; i++)
+  {
+    if (!_inStep[i] && _q[i]->full()) _q[i]->pop(nullptr);
+  }
+
+  if (pick < 0)
+  {
+    bool inStep = false;
+    for (uint8_t i = 0; i < MIRRORS; i++)
+    {
+      inStep |= _inStep[i];
+      if (pick < 0 && _q[i]->head(f)) pick = i;
+    }
+    if (pick < 0) { _waiting = false; return 0; }   // both paths are empty
+
+    // no path has the next frame, give a path in step a moment to bring it
+    if (_seq > 0)
+    {
+      if (inStep && !_waiting) { _waiting = true; _msWait = msNow; }
+      if (inStep && msNow - _msWait < SPLICE_WAIT_MS) return 0;
+      jumps++;
+    }
+    memset(_inStep, 0, sizeof(_inStep));
+  }
+  _waiting = false;
+
+  _q[pick]->head(f);
+  _q[pick]->pop(out);
+  if (_active >= 0 && pick != _active) switches++;
+  _active = pick;
+  _history[_seq % HISTORY_FRAMES] = f.hash;
+  _seq++;
+  _inStep[pick] = true;
+  _headSeq[pick] = _seq;
+  frames[pick]++;
+  return f.len;
+}
+
+
+/**
+ * Start a new response, metaInt 0 if it has no metadata
+ */
+void IcyStripper::begin(uint32_t metaInt)
+{
+  _metaInt = _audioLeft = metaInt;
+  _inMeta = false;
+  _metaLeft = _metaLen = 0;
+}
+
+
+/**
+ * Remove the metadata blocks from the received bytes, 
+ * returns the number of audio bytes left at the start
+ */
+size_t IcyStripper::strip(uint8_t *buf, size_t len)
+{
+  if (_metaInt == 0) return len;
+  size_t out = 0;
+  for (size_t i = 0; i < len; )
+  {
+    if (_audioLeft > 0)
+    {
+      size_t n = std::min<size_t>(_audioLeft, len - i);
+      memmove(buf + out, buf + i, n);
+      out += n;
+      i += n;
+      _audioLeft -= n;
+    }
+    else if (!_inMeta)
+    {
+      _metaLeft = buf[i++] * 16;
+      _metaLen = 0;
+      _inMeta = _metaLeft > 0;
+      if (!_inMeta) _audioLeft = _metaInt;
+    }
+    else
+    {
+      size_t n = std::min<size_t>(_metaLeft, len - i);
+      size_t keep = std::min<size_t>(n, ICY_META_MAX - _metaLen);
+      memcpy(_meta + _metaLen, buf + i, keep);
+      _metaLen += keep;
+      _metaLeft -= n;
+      i += n;
+      if (_metaLeft == 0)
+      {
+        parseMeta();
+        _inMeta = false;
+        _audioLeft = _metaInt;
+      }
+    }
+  }
+  return out;
+}
+
+
+void IcyStripper::parseMeta()
+{
+  static const char key[] = "StreamTitle='";
+  _meta[_metaLen] = '\0';
+  const char *p = strstr(_meta, key);
+  if (p == nullptr) return;
+  p += sizeof(key) - 1;
+  const char *end = strstr(p, "';");
+  size_t len = std::min<size_t>(end ? end - p : strlen(p), ICY_TITLE_MAX - 1);
+  if (strncmp(_title, p, len) == 0 && _title[len] == '\0') return;
+  memcpy(_title, p, len);
+  _title[len] = '\0';
+  _titleNew = true;
+}
+
+
+/**
+ * Copy the title to out if it changed since the last call
+ */
+bool IcyStripper::newTitle(char *out, size_t size)
+{
+  if (!_titleNew) return false;
+  strlcpy(out, _title, size);
+  _titleNew = false;
+  return true;
+}
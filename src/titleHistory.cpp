@@ -0,0 +1,265 @@
+#include <Arduino.h>
+#include <time.h>
+#include "clock.h"
+#include "titleHistory.h"
+
+#define HISTORY_STATIONS  32    // stations with their own history
+#define HISTORY_DEPTH     20    // titles kept per station
+#define ARENA_SIZE        8192  // bytes for all interned titles
+#define INDEX_SLOTS       1024  // hash slots, power of 2, 3/4 of it > stations * depth
+#define NTP_SERVER        "pool.ntp.org"
+#define TIME_ZONE         "CET-1CEST,M3.5.0,M10.5.0/3"
+#define TIME_SYNCED       1600000000  // earlier times are before the first SNTP sync
+
+/**
+ * Titles are interned into a fixed arena. Each record consists of
+ * a header followed by the zero terminated string. A record is 
+ * referenced by its offset and freed when its refcount drops to 0. 
+ * Free records are reclaimed by compacting the arena when it is full.
+ */
+struct Record { uint16_t len; uint16_t refs; uint32_t hash; char str[]; };
+struct Entry  { uint16_t offset; uint32_t time; uint32_t seq; };   // time in seconds since boot until synced
+
+static uint8_t  arena[ARENA_SIZE] __attribute__((aligned(4)));
+static uint16_t arenaUsed = 0;
+static uint16_t titleIndex[INDEX_SLOTS]; // offset + 1 of interned record, 0 = empty
+static uint16_t indexUsed = 0;
+static Entry    history[HISTORY_STATIONS][HISTORY_DEPTH];
+static uint8_t  head[HISTORY_STATIONS];  // next slot to write
+static uint8_t  count[HISTORY_STATIONS];
+static uint32_t seqNext = 0;            // age of entries across stations
+static bool     synced = false;         // entry times are wall clock times
+
+static inline Record *recordAt(uint16_t offset) { return (Record *)(arena + offset); }
+static inline uint16_t recordSize(uint16_t len) { return (sizeof(Record) + len + 1 + 3) & ~3; }
+
+static uint32_t hashOf(const char *s, size_t len)
+{
+  uint32_t h = 2166136261u;
+  while (len--) h = (h ^ (uint8_t)*s++) * 16777619u;
+  return h;
+}
+
+
+/**
+ * Rebuild the hash index from the records in the arena
+ */
+static void rebuildIndex()
+{
+  memset(titleIndex, 0, sizeof(titleIndex));
+  indexUsed = 0;
+  for (uint16_t off = 0; off < arenaUsed; off += recordSize(recordAt(off)->len))
+  {
+    Record *r = recordAt(off);
+    if (r->refs == 0) continue;
+    uint16_t slot = r->hash & (INDEX_SLOTS - 1);
+    while (titleIndex[slot]) slot = (slot + 1) & (INDEX_SLOTS - 1);
+    titleIndex[slot] = off + 1;
+    indexUsed++;
+  }
+}
+
+
+/**
+ * Slide all referenced records to the start of the arena
+ * and fix the offsets in the history entries
+ */
+static void compactArena()
+{
+  uint16_t dst = 0;
+  for (uint16_t src = 0; src < arenaUsed; )
+  {
+    uint16_t size = recordSize(recordAt(src)->len);
+    if (recordAt(src)->refs > 0)
+    {
+      if (dst != src)
+      {
+        for (uint8_t s = 0; s < HISTORY_STATIONS; s++)
+          for (uint8_t i = 0; i < HISTORY_DEPTH; i++)
+            if (history[s][i].offset == src) history[s][i].offset = dst;
+        memmove(arena + dst, arena + src, size);
+      }
+      dst += size;
+    }
+    src += size;
+  }
+  arenaUsed = dst;
+  rebuildIndex();
+}
+
+
+/**
+ * Drop a reference and return the bytes which become free
+ */
+static uint16_t release(uint16_t offset)
+{
+  Record *r = recordAt(offset);
+  if (r->refs > 0 && --r->refs == 0) return recordSize(r->len);
+  return 0;
+}
+
+
+/**
+ * Remove the oldest entry of all stations, returns the bytes
+ * freed in the arena or -1 if the history is empty
+ */
+static int32_t evictOldest()
+{
+  int8_t oldest = -1;
+  uint32_t seqOldest = 0;
+  for (uint8_t s = 0; s < HISTORY_STATIONS; s++)
+  {
+    if (count[s] == 0) continue;
+    const Entry &e = history[s][(head[s] + HISTORY_DEPTH - count[s]) % HISTORY_DEPTH];
+    if (oldest < 0 || (int32_t)(e.seq - seqOldest) < 0) { oldest = s; seqOldest = e.seq; }
+  }
+  if (oldest < 0) return -1;
+  const Entry &e = history[oldest][(head[oldest] + HISTORY_DEPTH - count[oldest]) % HISTORY_DEPTH];
+  count[oldest]--;
+  return release(e.offset);
+}
+
+
+/**
+ * Return the offset of the interned string, adding it when 
+ * it is new. Returns -1 if neither arena nor index have room.
+ */
+static int32_t intern(const char *s)
+{
+  size_t len = strnlen(s, 255);
+  uint32_t h = hashOf(s, len);
+  uint16_t slot = h & (INDEX_SLOTS - 1);
+  for (; titleIndex[slot]; slot = (slot + 1) & (INDEX_SLOTS - 1))
+  {
+    Record *r = recordAt(titleIndex[slot] - 1);
+    if (r->hash == h && r->len == len && strncmp(r->str, s, len) == 0) return titleIndex[slot] - 1;
+  }
+
+  uint16_t size = recordSize(len);
+  if (arenaUsed + size > ARENA_SIZE || indexUsed >= INDEX_SLOTS * 3 / 4)
+  {
+    compactArena();
+    // make room at the expense of the oldest titles of any station
+    int32_t freed = 0;
+    while (arenaUsed + size > ARENA_SIZE + freed)
+    {
+      int32_t n = evictOldest();
+      if (n < 0) return -1;
+      freed += n;
+    }
+    if (freed) compactArena();
+    slot = h & (INDEX_SLOTS - 1);
+    while (titleIndex[slot]) slot = (slot + 1) & (INDEX_SLOTS - 1);
+  }
+  uint16_t off = arenaUsed;
+  Record *r = recordAt(off);
+  r->len  = len;
+  r->refs = 0;
+  r->hash = h;
+  memcpy(r->str, s, len);
+  r->str[len] = '\0';
+  arenaUsed += size;
+  titleIndex[slot] = off + 1;
+  indexUsed++;
+  return off;
+}
+
+
+/**
+ * The current time in the unit of the entries. Titles which arrived 
+ * before the first SNTP sync carry the seconds since boot, on the 
+ * sync they are converted to wall clock time.
+ */
+static uint32_t entryTime()
+{
+  if (synced) return clockTime();
+  time_t now = clockTime();
+  uint32_t uptime = clockMs() / 1000;
+  if (now < TIME_SYNCED) return uptime;
+
+  for (uint8_t s = 0; s < HISTORY_STATIONS; s++)
+    for (uint8_t i = 0; i < count[s]; i++)
+    {
+      Entry &e = history[s][(head[s] + HISTORY_DEPTH - 1 - i) % HISTORY_DEPTH];
+      e.time = now - (uptime - e.time);
+    }
+  synced = true;
+  return now;
+}
+
+
+/**
+ * Start SNTP so that the titles get a wall clock timestamp
+ */
+void initTitleHistory()
+{
+  configTzTime(TIME_ZONE, NTP_SERVER);
+}
+
+
+/**
+ * Append a title to the history of a station. Repetitions of
+ * the latest title, e.g. when reconnecting, are ignored.
+ */
+void recordTitle(uint8_t station, const char *title)
+{
+  if (station >= HISTORY_STATIONS || title == nullptr || *title == '\0') return;
+
+  uint8_t latest = (head[station] + HISTORY_DEPTH - 1) % HISTORY_DEPTH;
+  if (count[station] > 0 && strcmp(recordAt(history[station][latest].offset)->str, title) == 0) return;
+
+  uint32_t now = entryTime();   // converts the earlier entries first
+  int32_t off = intern(title);
+  if (off < 0) return;
+
+  Entry &e = history[station][head[station]];
+  if (count[station] == HISTORY_DEPTH) release(e.offset);
+  else count[station]++;
+  recordAt(off)->refs++;
+  e.offset = off;
+  e.time   = now;
+  e.seq    = seqNext++;
+  head[station] = (head[station] + 1) % HISTORY_DEPTH;
+}
+
+
+/**
+ * Call cb for every title of the station not older than maxAge seconds,
+ * newest first. Returns the number of titles reported. The title pointer 
+ * is only valid during the callback.
+ */
+uint8_t queryTitleHistory(uint8_t station, uint32_t maxAge, void (*cb)(time_t t, const char *title, void *ctx), void *ctx)
+{
+  if (station >= HISTORY_STATIONS) return 0;
+  uint32_t now = entryTime();
+  uint8_t n = 0;
+  for (uint8_t i = 1; i <= count[station]; i++)
+  {
+    const Entry &e = history[station][(head[station] + HISTORY_DEPTH - i) % HISTORY_DEPTH];
+    if (maxAge && (uint32_t)(now - e.time) > maxAge) break;
+    cb(e.time, recordAt(e.offset)->str, ctx);
+    n++;
+  }
+  return n;
+}
+
+
+static void printTitle(time_t t, const char *title, void *ctx)
+{
+  struct tm tm;
+  char hhmm[8];
+  localtime_r(&t, &tm);
+  strftime(hhmm, sizeof(hhmm), "%H:%M", &tm);
+  Serial.printf("  %s  %s\r\n", hhmm, title);
+}
+
+
+/**
+ * Print the titles of the last hour on the monitor
+ */
+void showTitleHistory(uint8_t station)
+{
+  Serial.printf("\r\nTitles of the last hour:\r\n");
+  if (queryTitleHistory(station, 3600, printTitle, nullptr) == 0) Serial.printf("  none\r\n");
+  Serial.printf("  (arena %u of %u bytes used)\r\n", arenaUsed, ARENA_SIZE);
+}
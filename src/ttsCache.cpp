@@ -0,0 +1,228 @@
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <HTTPClient.h>
+#include "Audio.h"
+#include "readAheadFS.h"
+#include "httpPool.h"
+#include "metrics.h"
+#include "clock.h"
+#include "fileSystems.h"
+#include "audioTask.h"
+#include "ttsCache.h"
+
+#define TTS_DIR            "/tts"
+#define TTS_HOST           "translate.google.com"
+#define TTS_MAX_CHUNK      180    // google refuses longer texts per request
+#define TTS_MAX_JOBS       40
+#define TTS_RATE_LIMIT     8192   // bytes per second for the background download
+#define TTS_SAFETY_PERCENT 60     // pause download while the stream buffer is below
+#define TTS_STABLE_PERCENT 80     // stream buffer fill which counts as stable
+#define TTS_TASK_PRIORITY  (tskIDLE_PRIORITY + 1)
+#define TTS_TASK_STACK     12288  // room for a TLS handshake
+#define TTS_TIMEOUT_MS     5000   // a response which stalls that long is given up
+
+struct TtsJob { const char *txt; const char *lang; };
+
+static TtsJob   jobs[TTS_MAX_JOBS];
+static uint8_t  nbrJobs     = 0;
+static bool     taskStarted = false;
+static volatile uint8_t nbrRendered = 0;
+
+
+/**
+ * Register a text to be pre-rendered in the background
+ */
+void addTtsJob(const char *txt, const char *lang)
+{
+  if (nbrJobs < TTS_MAX_JOBS) jobs[nbrJobs++] = { txt, lang };
+}
+
+
+/**
+ * Build the cache file name from a FNV-1a hash of language and text
+ */
+static void ttsCachePath(const char *txt, const char *lang, char *path, size_t len)
+{
+  uint32_t h = 2166136261u;
+  for (const char *p = lang; *p; p++) h = (h ^ (uint8_t)*p) * 16777619u;
+  for (const char *p = txt;  *p; p++) h = (h ^ (uint8_t)*p) * 16777619u;
+  snprintf(path, len, TTS_DIR "/%08x.mp3", h);
+}
+
+
+/**
+ * Percent encode n characters of txt into the url
+ */
+static void appendEncoded(String &url, const char *txt, size_t n)
+{
+  static const char hex[] = "0123456789ABCDEF";
+  for (size_t i = 0; i < n; i++)
+  {
+    uint8_t c = txt[i];
+    char enc[4] = { (char)c, 0, 0, 0 };
+    if (! (isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~'))
+    {
+      enc[0] = '%'; enc[1] = hex[c >> 4]; enc[2] = hex[c & 0x0f];
+    }
+    url += enc;
+  }
+}
+
+
+/**
+ * Wait while the live stream needs the bandwidth and keep
+ * the download below TTS_RATE_LIMIT
+ */
+static void throttle(uint32_t bytesSoFar, uint32_t msStart)
+{
+  while (audioRunning() && audioFillPercent() < TTS_SAFETY_PERCENT)
+  {
+    clockSleep(200);
+  }
+  uint32_t msEarliest = msStart + (uint64_t)bytesSoFar * 1000 / TTS_RATE_LIMIT;
+  int32_t msAhead = (int32_t)(msEarliest - clockMs());
+  if (msAhead > 0) clockSleep(msAhead);
+}
+
+
+/**
+ * File sink for HTTPClient::writeToStream(), which takes care of the
+ * content length and chunked encoding. Each write waits for the throttle,
+ * so the download is held back from the socket.
+ */
+class ThrottledFile : public Stream
+{
+  public:
+    ThrottledFile(File &f) : _f(f), _msStart(clockMs()) {}
+
+    size_t write(const uint8_t *buf, size_t size) override
+    {
+      throttle(_bytes, _msStart);
+      _bytes += size;
+      return _f.write(buf, size);
+    }
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    int available() override         { return 0; }
+    int read() override              { return -1; }
+    int peek() override              { return -1; }
+
+  private:
+    File &_f;
+    uint32_t _msStart;
+    uint32_t _bytes = 0;
+};
+
+
+/**
+ * Download one chunk of text as mp3 and append it to the file
+ */
+static bool renderChunk(File &f, const char *txt, size_t n, const char *lang)
+{
+  HTTPClient http;
+  String url = "https://" TTS_HOST "/translate_tts?ie=UTF-8&client=tw-ob&tl=";
+  url += lang;
+  url += "&q=";
+  appendEncoded(url, txt, n);
+
+  WiFiClient *client = httpPoolAcquire(TTS_HOST, 443, true);
+  if (client == nullptr) return false;
+  http.setReuse(true);
+  http.setTimeout(TTS_TIMEOUT_MS);
+  if (! http.begin(*client, url)) 
+  {
+    httpPoolRelease(client, false);
+    return false;
+  }
+  int code = http.GET();
+  metricAdd(HTTP_REQUESTS);
+  if (code != HTTP_CODE_OK)
+  {
+    log_w("TTS download failed: %d", code);
+    http.end();
+    httpPoolRelease(client, false);
+    return false;
+  }
+
+  ThrottledFile sink(f);
+  int bytes = http.writeToStream(&sink);
+  if (bytes < 0) log_w("TTS download failed: %s", HTTPClient::errorToString(bytes).c_str());
+  http.end();
+  httpPoolRelease(client, bytes > 0 && client->connected());
+  return bytes > 0;
+}
+
+
+/**
+ * Render a whole text, split at blanks into chunks google accepts
+ */
+static bool renderText(const char *txt, const char *lang, const char *path)
+{
+  const char tmpPath[] = TTS_DIR "/render.tmp";
+  File f = LittleFS.open(tmpPath, FILE_WRITE);
+  if (!f) return false;
+
+  bool ok = true;
+  const char *p = txt;
+  while (ok && *p)
+  {
+    size_t n = strlen(p);
+    if (n > TTS_MAX_CHUNK)
+    {
+      n = TTS_MAX_CHUNK;
+      while (n > 0 && p[n] != ' ') n--;
+      if (n == 0) n = TTS_MAX_CHUNK;
+    }
+    ok = renderChunk(f, p, n, lang);
+    p += n;
+    while (*p == ' ') p++;
+  }
+  f.close();
+  ok = ok && LittleFS.rename(tmpPath, path);
+  if (!ok) LittleFS.remove(tmpPath);
+  return ok;
+}
+
+
+static void ttsPrerenderTask(void *)
+{
+  char path[32];
+
+  for (uint8_t i = 0; i < nbrJobs; i++)
+  {
+    ttsCachePath(jobs[i].txt, jobs[i].lang, path, sizeof(path));
+    if (LittleFS.exists(path) || renderText(jobs[i].txt, jobs[i].lang, path)) nbrRendered++;
+  }
+  log_i("TTS pre-rendering done, %d of %d texts cached", nbrRendered, nbrJobs);
+  vTaskDelete(NULL);
+}
+
+
+/**
+ * Start the low priority pre-render task once the stream is stable. 
+ * Returns true once it is started, until then the scheduler calls 
+ * this again.
+ */
+bool ttsPrerenderPoll()
+{
+  if (taskStarted) return true;
+  if (!audioRunning() || audioFillPercent() < TTS_STABLE_PERCENT) return false;
+
+  taskStarted = true;
+  LittleFS.mkdir(TTS_DIR);
+  xTaskCreatePinnedToCore(ttsPrerenderTask, "ttsPrerender", TTS_TASK_STACK, NULL, TTS_TASK_PRIORITY, NULL, 0);
+  return true;
+}
+
+
+/**
+ * Speak the text from the cache or, if it is not yet 
+ * rendered, with the online TTS service
+ */
+void speak(Audio &out, const char *txt, const char *lang)
+{
+  char path[32];
+  ttsCachePath(txt, lang, path, sizeof(path));
+  if (LittleFS.exists(path)) out.connecttoFS(littlefsRA, path);
+  else                       out.connecttospeech(txt, lang);
+}
@@ -0,0 +1,176 @@
+#include <Arduino.h>
+#include <WebServer.h>
+#include "metrics.h"
+#include "webPage.h"
+#include "memPolicy.h"
+#include "menu.h"
+#include "netProbe.h"
+#include "audioTask.h"
+#include "titleHistory.h"
+#include "webUi.h"
+
+#define WEB_PORT        80
+#define PAGE_MAX_AGE    "86400"   // revalidated with the ETag after a day
+#define HISTORY_AGE     3600
+#define JSON_SIZE       4096
+#define MONITOR_KEYS    "BXxRNw"  // benchmarks, self test, probe and recording, not offered on the web
+
+static WebServer server(WEB_PORT);
+static char *json;
+static size_t jsonLen;
+
+
+/**
+ * Append to the JSON response, output beyond
+ * the buffer is dropped
+ */
+static void add(const char *fmt, ...)
+{
+  if (!json || jsonLen >= JSON_SIZE - 1) return;
+  va_list args;
+  va_start(args, fmt);
+  int n = vsnprintf(json + jsonLen, JSON_SIZE - jsonLen, fmt, args);
+  va_end(args);
+  if (n > 0) jsonLen = std::min<size_t>(jsonLen + n, JSON_SIZE - 1);
+}
+
+static void addString(const char *s)
+{
+  add("\"");
+  for (; *s; s++)
+  {
+    if (*s == '"' || *s == '\\') add("\\%c", *s);
+    else if ((uint8_t)*s < 0x20) add("\\u%04x", *s);
+    else add("%c", *s);
+  }
+  add("\"");
+}
+
+static void sendJson()
+{
+  server.send(200, "application/json", json ? json : "{}");
+  metricAdd(WEB_BYTES_SENT, jsonLen);
+  jsonLen = 0;
+}
+
+
+/**
+ * The page is stored gzipped in flash and sent from there,
+ * a browser with the current version gets a 304 only
+ */
+static void handlePage()
+{
+  uint32_t us = micros();
+  metricAdd(WEB_REQUESTS, 1);
+  server.sendHeader("ETag", WEB_PAGE_ETAG);
+  server.sendHeader("Cache-Control", "public, max-age=" PAGE_MAX_AGE);
+  if (server.header("If-None-Match") == WEB_PAGE_ETAG)
+  {
+    server.send(304);
+    metricAdd(WEB_NOT_MODIFIED, 1);
+    return;
+  }
+  server.sendHeader("Content-Encoding", "gzip");
+  server.send_P(200, "text/html", (PGM_P)webPageGz, sizeof(webPageGz));
+  metricAdd(WEB_BYTES_SENT, sizeof(webPageGz));
+  metricSet(WEB_PAGE_US, micros() - us);
+}
+
+
+/**
+ * The web UI is not authenticated, keys which run for seconds 
+ * or write to flash are only accepted from the monitor
+ */
+static bool webKey(char key)
+{
+  return key && strchr(MONITOR_KEYS, key) == nullptr;
+}
+
+
+static void addMenuItem(char key, const char *txt, void *ctx)
+{
+  if (!webKey(key)) return;
+  if (jsonLen > 1) add(",");
+  add("{\"key\":\"%c\",\"txt\":", key);
+  addString(txt);
+  add("}");
+}
+
+static void handleMenu()
+{
+  metricAdd(WEB_REQUESTS, 1);
+  add("[");
+  listMenu(addMenuItem, nullptr);
+  add("]");
+  sendJson();
+}
+
+
+static void addTitle(time_t t, const char *title, void *ctx)
+{
+  if (*(bool *)ctx) add(",");
+  *(bool *)ctx = true;
+  add("{\"time\":%ld,\"title\":", (long)t);
+  addString(title);
+  add("}");
+}
+
+/**
+ * State of the zone the keys act on and its titles of the last 
+ * hour, which the audio task adds to while holding the lock
+ */
+static void handleStatus()
+{
+  metricAdd(WEB_REQUESTS, 1);
+  int station = menuZone ? zone2Station : currentStation;
+  add("{\"zone\":%d,\"station\":", menuZone + 1);
+  addString(station >= 0 ? menuText(station) : "off");
+  add(",\"volume\":%d,\"history\":[", menuZone ? zone2Volume : currentVolume);
+  bool more = false;
+  audioLock();
+  if (station >= 0) queryTitleHistory(station, HISTORY_AGE, addTitle, &more);
+  audioUnlock();
+  add("]}");
+  sendJson();
+}
+
+
+static void handleKey()
+{
+  metricAdd(WEB_REQUESTS, 1);
+  String k = server.arg("k");
+  if (k.length() == 1 && !webKey(k[0])) server.send(403, "text/plain", "key only on the monitor");
+  else if (k.length() == 1 && runMenuKey(k[0])) server.send(204);
+  else server.send(404, "text/plain", "unknown key");
+}
+
+
+/**
+ * Set the server of the network probe, which runs from the monitor
+ */
+static void handleProbe()
+{
+  metricAdd(WEB_REQUESTS, 1);
+  if (setProbeServer(server.arg("server").c_str())) server.send(204);
+  else server.send(400, "text/plain", "server must be host:port");
+}
+
+
+void initWebUi()
+{
+  json = (char *)memAlloc(MEM_WEB_JSON, JSON_SIZE);
+  static const char *headers[] = { "If-None-Match" };
+  server.collectHeaders(headers, 1);
+  server.on("/", HTTP_GET, handlePage);
+  server.on("/api/menu", HTTP_GET, handleMenu);
+  server.on("/api/status", HTTP_GET, handleStatus);
+  server.on("/api/key", HTTP_POST, handleKey);
+  server.on("/api/probe", HTTP_POST, handleProbe);
+  server.begin();
+}
+
+
+void webUiPoll()
+{
+  server.handleClient();
+}
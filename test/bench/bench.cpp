@@ -0,0 +1,308 @@
+#include <Arduino.h>
+#include <dirent.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "bench.h"
+#include "mp3Sync.h"
+#include "splicer.h"
+#include "dns.h"
+#include "menuKeys.h"
+#include "hostBaseline.h"
+#include "dsp.h"
+#include "charset.h"
+#include "playlist.h"
+
+/**
+ * Benchmark of the kernels which run on the host: DSP stages, parsers 
+ * over their worst case inputs, the stream title conversion, the menu 
+ * dispatch and the frames of the splicer. The slowest inputs the fuzz 
+ * targets found, corpus/<target>/worst-*, are replayed as well. Each 
+ * kernel runs REPEATS times and the best result counts. It is reported 
+ * relative to a reference kernel timed the same way, so the baselines 
+ * in hostBaseline.h hold on other hosts. The exit status is the number 
+ * of regressions, so a slower change fails the build.
+ */
+#define REPEATS       7       // the host is shared, the best run counts
+#define PARSE_BYTES   2048
+#define RUNS          200
+#define QUEUE_FRAMES_RUN 1000
+#define CORPUS        "../fuzz/corpus/"
+#define REF_BYTES     1024
+#define MENU_KEYS_USED "0123456789abcdefghijklmnop!.,tuwyBXx+-TODPZCAHMJLNVRS"   // the keys of the menu
+
+uint8_t currentZone() { return 0; }
+int httpFetch(const char *url, char *body, size_t size) { return -1; }   // playlists are not fetched here
+
+struct Result { std::string name, unit; uint32_t value; };
+static std::vector<Result> results;
+
+/**
+ * Keep the lowest value of each kernel, in the order of the first run
+ */
+static void keepBest(const char *name, uint32_t value, const char *unit)
+{
+  for (auto &r : results) if (r.name == name) { r.value = std::min(r.value, value); return; }
+  results.push_back({ name, unit, value });
+}
+
+
+static uint64_t nsNow()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+/**
+ * Worst case time of each parser for an input of PARSE_BYTES
+ */
+static void benchParsers()
+{
+  static uint8_t buf[PARSE_BYTES];
+  char url[256];
+  uint64_t worstSync = 0, worstUtf8 = 0, worstPlaylist = 0;
+
+  for (uint8_t i = 0; worstCaseMp3(i, buf, PARSE_BYTES); i++)
+  {
+    uint64_t ns = nsNow();
+    for (int r = 0; r < RUNS; r++) mp3FindSync(buf, PARSE_BYTES);
+    worstSync = std::max(worstSync, (nsNow() - ns) / RUNS);
+  }
+  for (uint8_t i = 0; worstCaseText(i, buf, PARSE_BYTES); i++)
+  {
+    uint64_t nsUtf8 = 0, nsPlaylist = 0;
+    for (int r = 0; r < RUNS; r++)
+    {
+      worstCaseText(i, buf, PARSE_BYTES);
+      uint64_t ns = nsNow();
+      toUtf8((char *)buf, PARSE_BYTES);
+      nsUtf8 += nsNow() - ns;
+      worstCaseText(i, buf, PARSE_BYTES);
+      ns = nsNow();
+      parsePlaylist((char *)buf, url, sizeof(url));
+      nsPlaylist += nsNow() - ns;
+    }
+    worstUtf8 = std::max(worstUtf8, nsUtf8 / RUNS);
+    worstPlaylist = std::max(worstPlaylist, nsPlaylist / RUNS);
+  }
+  keepBest("parse mp3 sync worst case", worstSync, "ns/2 KB");
+  keepBest("parse charset worst case", worstUtf8, "ns/2 KB");
+  keepBest("parse playlist worst case", worstPlaylist, "ns/2 KB");
+}
+
+
+typedef std::vector<uint8_t> Input;
+
+static std::vector<Input> loadWorst(const char *target)
+{
+  std::vector<Input> inputs;
+  std::string dir = std::string(CORPUS) + target;
+  DIR *d = opendir(dir.c_str());
+  while (struct dirent *e = d ? readdir(d) : nullptr)
+  {
+    if (strncmp(e->d_name, "worst-", 6) != 0) continue;
+    FILE *f = fopen((dir + "/" + e->d_name).c_str(), "rb");
+    Input in;
+    for (int c; (c = fgetc(f)) != EOF; ) in.push_back(c);
+    fclose(f);
+    inputs.push_back(in);
+  }
+  if (d) closedir(d);
+  return inputs;
+}
+
+
+/**
+ * The worst inputs of a fuzz target through its parser, the 
+ * same way the target calls it. The slowest per KB counts.
+ */
+static void replayWorst(const char *target, const char *name, void (*parse)(const Input &in))
+{
+  uint64_t worstNsPerKb = 0;
+  for (auto &in : loadWorst(target))
+  {
+    uint64_t ns = nsNow();
+    for (int r = 0; r < RUNS; r++) parse(in);
+    worstNsPerKb = std::max<uint64_t>(worstNsPerKb, (nsNow() - ns) * 1024 / RUNS / std::max<size_t>(in.size(), 1));
+  }
+  keepBest(name, worstNsPerKb, "ns/KB");
+}
+
+
+static void benchWorstCorpus()
+{
+  replayWorst("mp3sync", "replay mp3 sync worst corpus", [](const Input &in) { mp3FindSync(in.data(), in.size()); });
+  replayWorst("charset", "replay charset worst corpus", [](const Input &in) 
+  {
+    if (in.empty()) return;
+    size_t bufSize = 1 + in[0] % 64 * 4;   // as in fuzz_charset
+    std::vector<char> buf(bufSize + std::max(bufSize, in.size()));
+    memcpy(buf.data(), in.data() + 1, in.size() - 1);
+    buf[in.size() - 1] = '\0';
+    toUtf8(buf.data(), bufSize);
+  });
+  replayWorst("playlist", "replay playlist worst corpus", [](const Input &in) 
+  {
+    std::string body(in.begin(), in.end());
+    char url[64];
+    parsePlaylist(body.c_str(), url, sizeof(url));
+  });
+  replayWorst("dns", "replay dns worst corpus", [](const Input &in) 
+  {
+    uint32_t addrs[4];
+    uint16_t id = in.size() >= 2 ? in[0] << 8 | in[1] : 0;
+    dnsParseAnswer(in.data(), in.size(), id, addrs, 4);
+  });
+}
+
+
+/**
+ * The reference kernel: FNV-1a over 1 KB, a chain of dependent integer 
+ * operations which the compiler cannot vectorise
+ */
+static uint64_t refNs = UINT64_MAX;
+
+static void benchReference()
+{
+  static uint8_t buf[REF_BYTES];
+  for (auto &b : buf) b = esp_random();
+  volatile uint32_t sink;
+  uint64_t ns = nsNow();
+  for (int r = 0; r < RUNS; r++)
+  {
+    uint32_t h = 2166136261u;
+    for (auto b : buf) h = (h ^ b) * 16777619u;
+    sink = h;
+  }
+  (void)sink;
+  refNs = std::min(refNs, (nsNow() - ns) / RUNS);
+}
+
+
+/**
+ * All printable keys through the dispatch table of the menu, 
+ * most of them miss as on the board
+ */
+static void benchMenuDispatch()
+{
+  for (uint8_t i = 0; MENU_KEYS_USED[i]; i++) menuKeySet(MENU_KEYS_USED[i], i);
+  volatile int found = 0;
+  uint64_t ns = nsNow();
+  for (int r = 0; r < RUNS; r++)
+  {
+    for (char key = ' '; key < 0x7F; key++) found += menuKeyFind(key);
+  }
+  keepBest("menu dispatch all keys", (nsNow() - ns) / RUNS, "ns/95 keys");
+}
+
+
+/**
+ * The same frames over both paths of a mirrored station, the second 
+ * one behind, through the queues and the splicer as the decoder takes 
+ * them. The decode itself is part of the audio library, which the host 
+ * build does not have.
+ */
+static void benchSplicePerFrame()
+{
+  static const uint8_t header[] = { 0xFF, 0xFB, 0x90, 0x64 };
+  static uint8_t ring[MIRRORS][16384];
+  static uint8_t frame[417], out[FRAME_MAX_LEN];
+  MirrorQueue q[MIRRORS] = { { ring[0], sizeof(ring[0]) }, { ring[1], sizeof(ring[1]) } };
+  Splicer splicer(q[0], q[1]);
+  std::vector<std::vector<uint8_t>> frames(QUEUE_FRAMES_RUN + 2);
+  for (auto &f : frames)
+  {
+    f.resize(sizeof(frame));
+    for (auto &b : f) b = esp_random();
+    memcpy(f.data(), header, sizeof(header));
+  }
+
+  uint64_t ns = nsNow();
+  for (int i = 0; i < QUEUE_FRAMES_RUN; i++)
+  {
+    q[0].append(frames[i + 2].data(), sizeof(frame));
+    q[1].append(frames[i].data(), sizeof(frame));
+    splicer.next(out, i * 26);
+  }
+  keepBest("mp3 frame through splicer", (nsNow() - ns) / QUEUE_FRAMES_RUN, "ns/frame");
+}
+
+
+/**
+ * The CPU of the host, for the header of the report
+ */
+static std::string hostCpu()
+{
+  FILE *f = fopen("/proc/cpuinfo", "r");
+  char line[256];
+  std::string cpu = "unknown";
+  while (f && fgets(line, sizeof(line), f))
+  {
+    if (strncmp(line, "model name", 10) != 0) continue;
+    cpu = strchr(line, ':') + 2;
+    cpu.erase(cpu.find_last_not_of("\n") + 1);
+    break;
+  }
+  if (f) fclose(f);
+  return cpu;
+}
+
+
+static void benchTitle()
+{
+  uint64_t ns = nsNow();
+  for (int r = 0; r < RUNS; r++) metadataToUtf8("Beyonc\xe9 \x96 D\xe9j\xe0 Vu (Live at Caf\xe9 Z\xfcrich)");
+  keepBest("parse stream title", (nsNow() - ns) / RUNS, "ns");
+}
+
+
+/**
+ * Frames of 128 kbit/s at 44.1 kHz through the queue of one mirror 
+ * path: appended as they arrive, cut at the headers and popped
+ */
+static void benchSpliceQueue()
+{
+  static const uint8_t header[] = { 0xFF, 0xFB, 0x90, 0x64 };
+  static uint8_t ring[16384];
+  static uint8_t frame[417], out[FRAME_MAX_LEN];
+  MirrorQueue q(ring, sizeof(ring));
+  SpliceFrame f;
+
+  uint64_t ns = 0;
+  for (int i = 0; i < QUEUE_FRAMES_RUN; i++)
+  {
+    for (auto &b : frame) b = esp_random();
+    memcpy(frame, header, sizeof(header));
+    uint64_t t = nsNow();
+    q.append(frame, sizeof(frame));
+    while (q.head(f)) q.pop(out);
+    ns += nsNow() - t;
+  }
+  keepBest("splice queue append + pop", ns / QUEUE_FRAMES_RUN, "ns/frame");
+}
+
+
+int main(int argc, char **argv)
+{
+  bool csv = argc > 1 && strcmp(argv[1], "--csv") == 0;
+  for (int r = 0; r < REPEATS; r++)
+  {
+    benchmarkDsp(keepBest);
+    benchParsers();
+    benchTitle();
+    benchSpliceQueue();
+    benchWorstCorpus();
+    benchMenuDispatch();
+    benchSplicePerFrame();
+    benchReference();
+  }
+
+  if (!csv) Serial.printf("Host %s, reference kernel %u ns, results in mref, 1/1000 of it\r\n", hostCpu().c_str(), (uint32_t)refNs);
+  benchBegin(hostBaselines, sizeof(hostBaselines) / sizeof(hostBaselines[0]), csv);
+  for (auto &r : results) 
+  {
+    std::string unit = "mref" + r.unit.substr(2);   // ns/2 KB becomes mref/2 KB
+    benchReport(r.name.c_str(), (uint64_t)r.value * 1000 / refNs, unit.c_str());
+  }
+  return benchEnd();
+}
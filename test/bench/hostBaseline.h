@@ -0,0 +1,28 @@
+#pragma once
+#include "bench.h"
+
+/**
+ * Results of the host benchmark in mref, 1/1000 of the reference kernel 
+ * timed in the same run, so they carry over between x86-64 hosts. 
+ * Recorded with g++ 12 -O2 on an Intel Xeon build host, the value is the 
+ * slowest of several runs with some headroom, other jobs share the host. 
+ * To record them, run "make -C test/bench csv" and copy the values.
+ */
+static const BenchBaseline hostBaselines[] =
+{
+  { "dsp gap conceal",            3000, 30, false },
+  { "dsp volume",                 1850, 30, false },
+  { "dsp volume + dither",        4600, 30, false },
+  { "dsp level meter",            1400, 30, false },
+  { "parse mp3 sync worst case",  5750, 30, false },
+  { "parse charset worst case",   6350, 30, false },
+  { "parse playlist worst case",  6350, 30, false },
+  { "parse stream title",          150, 30, false },
+  { "splice queue append + pop",   520, 30, false },
+  { "replay mp3 sync worst corpus", 2800, 30, false },
+  { "replay charset worst corpus",  4500, 30, false },
+  { "replay playlist worst corpus", 5250, 30, false },
+  { "replay dns worst corpus",       410, 30, false },
+  { "menu dispatch all keys",        170, 30, false },
+  { "mp3 frame through splicer",     800, 30, false },
+};
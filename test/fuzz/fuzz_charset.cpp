@@ -0,0 +1,41 @@
+#include <Arduino.h>
+#include <vector>
+#include "charset.h"
+
+/**
+ * toUtf8() in place on arbitrary bytes and buffer sizes, the result 
+ * must fit, be zero terminated and be well formed UTF-8
+ */
+
+static bool wellFormed(const uint8_t *s, size_t len)
+{
+  for (size_t i = 0; i < len; )
+  {
+    uint8_t c = s[i];
+    size_t n = c < 0x80 ? 1 : (c & 0xE0) == 0xC0 ? 2 : (c & 0xF0) == 0xE0 ? 3 : (c & 0xF8) == 0xF0 ? 4 : 0;
+    if (n == 0 || i + n > len) return false;
+    for (size_t k = 1; k < n; k++) if ((s[i + k] & 0xC0) != 0x80) return false;
+    i += n;
+  }
+  return true;
+}
+
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+  if (size < 1) return 0;
+  size_t bufSize = 1 + data[0] % 64 * 4;   // the first byte picks the buffer size
+  std::vector<char> buf(bufSize + std::max(bufSize, size));
+  memcpy(buf.data(), data + 1, size - 1);
+  buf[size - 1] = '\0';
+
+  size_t len = toUtf8(buf.data(), bufSize);
+  if (len >= bufSize || buf[len] != '\0' || strlen(buf.data()) != len) abort();
+  if (!wellFormed((const uint8_t *)buf.data(), len)) abort();
+
+  std::vector<char> info(data + 1, data + size);
+  info.push_back('\0');
+  const char *s = metadataToUtf8(info.data());
+  if (!wellFormed((const uint8_t *)s, strlen(s))) abort();
+  return 0;
+}
@@ -0,0 +1,21 @@
+#include <Arduino.h>
+#include "mp3Sync.h"
+
+/**
+ * mp3FindSync() over arbitrary bytes, a sync it reports must start 
+ * a chain of SYNC_CHAIN consistent headers
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+  int32_t pos = mp3FindSync(data, size);
+  if (pos < 0) return 0;
+  Mp3Header first, h;
+  if ((size_t)pos + 4 > size || !parseMp3Header(data + pos, first)) abort();
+  size_t p = pos;
+  for (uint8_t i = 0; i < SYNC_CHAIN; i++)
+  {
+    if (p + 4 > size || !parseMp3Header(data + p, h) || h.version != first.version || h.sampleRate != first.sampleRate) abort();
+    p += h.frameLen;
+  }
+  return 0;
+}
@@ -0,0 +1,24 @@
+#include <Arduino.h>
+#include <vector>
+#include "playlist.h"
+
+/**
+ * parsePlaylist() over arbitrary bodies, a url it returns must fit 
+ * and be an http or https url
+ */
+
+// resolvePlaylist() of the same file is not fuzzed
+int httpFetch(const char *url, char *body, size_t size) { return -1; }
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+  std::vector<char> body(data, data + size);
+  body.push_back('\0');
+  char url[64];
+  memset(url, 0x55, sizeof(url));
+  if (!parsePlaylist(body.data(), url, sizeof(url))) return 0;
+  size_t len = strnlen(url, sizeof(url));
+  if (len == sizeof(url)) abort();
+  if (strncmp(url, "http://", 7) != 0 && strncmp(url, "https://", 8) != 0) abort();
+  return 0;
+}
@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * Driver for compilers without libFuzzer: runs every file of the given
+ * corpus directories through the target, then -runs=N random mutations
+ * of them. A crash or sanitizer report ends the run with a non-zero
+ * status, the input is saved as crash-input.
+ *
+ * With -worst=N each input is timed as well. The N inputs with the most
+ * cycles per byte are mutated further and finally written to the first
+ * corpus directory as worst-0 ... worst-<N-1>, replacing the previous
+ * ones. Time them in a build without sanitizers, see "make worst".
+ */
+#define MAX_INPUT_BYTES  4096   // mutations do not grow inputs beyond
+#define MIN_COST_BYTES   64     // shorter inputs are charged for this many bytes
+#define TIMING_RUNS      3      // the fastest of these counts
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+typedef std::vector<uint8_t> Input;
+struct Worst { Input in; double cyclesPerByte; };
+
+static std::vector<Input> corpus;
+static std::vector<Worst> worst;
+static size_t nbrWorst = 0;
+static uint32_t state = 2463534242u;
+
+static uint32_t next()
+{
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+
+/**
+ * Time stamp counter where there is one, otherwise nanoseconds
+ */
+static uint64_t cycles()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+
+static void load(const std::string &path)
+{
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0) return;
+  if (S_ISDIR(st.st_mode))
+  {
+    DIR *dir = opendir(path.c_str());
+    while (struct dirent *e = readdir(dir)) if (e->d_name[0] != '.') load(path + "/" + e->d_name);
+    closedir(dir);
+    return;
+  }
+  FILE *f = fopen(path.c_str(), "rb");
+  Input in(st.st_size);
+  if (fread(in.data(), 1, in.size(), f) == in.size()) corpus.push_back(in);
+  fclose(f);
+}
+
+
+/**
+ * Keep the input if it is among the slowest per byte so far,
+ * it then joins the corpus to be mutated further
+ */
+static void rank(const Input &in)
+{
+  uint64_t best = UINT64_MAX;
+  for (int r = 0; r < TIMING_RUNS; r++)
+  {
+    uint64_t t = cycles();
+    LLVMFuzzerTestOneInput(in.data(), in.size());
+    best = std::min(best, cycles() - t);
+  }
+  double cost = (double)best / std::max<size_t>(in.size(), MIN_COST_BYTES);
+  if (worst.size() == nbrWorst && cost <= worst.back().cyclesPerByte) return;
+  for (auto &w : worst) if (w.in == in) return;
+
+  if (worst.size() == nbrWorst) worst.pop_back();
+  size_t at = 0;
+  while (at < worst.size() && worst[at].cyclesPerByte >= cost) at++;
+  worst.insert(worst.begin() + at, { in, cost });
+  corpus.push_back(in);
+}
+
+
+static void save(const std::string &dir)
+{
+  DIR *d = opendir(dir.c_str());
+  while (struct dirent *e = d ? readdir(d) : nullptr)
+  {
+    if (strncmp(e->d_name, "worst-", 6) == 0) remove((dir + "/" + e->d_name).c_str());
+  }
+  if (d) closedir(d);
+  for (size_t i = 0; i < worst.size(); i++)
+  {
+    FILE *f = fopen((dir + "/worst-" + std::to_string(i)).c_str(), "wb");
+    fwrite(worst[i].in.data(), 1, worst[i].in.size(), f);
+    fclose(f);
+    printf("  worst-%zu: %zu bytes, %.1f cycles/byte\r\n", i, worst[i].in.size(), worst[i].cyclesPerByte);
+  }
+}
+
+
+static void run(const Input &in)
+{
+  FILE *f = fopen("crash-input", "wb");
+  fwrite(in.data(), 1, in.size(), f);
+  fclose(f);
+  LLVMFuzzerTestOneInput(in.data(), in.size());
+  if (nbrWorst) rank(in);
+}
+
+
+static Input mutate(Input in)
+{
+  for (uint32_t n = 1 + next() % 8; n > 0; n--)
+  {
+    size_t at = in.empty() ? 0 : next() % in.size();
+    switch (next() % 6)
+    {
+      case 0: if (!in.empty()) in[at] ^= 1 << (next() % 8); break;
+      case 1: if (!in.empty()) in[at] = next(); break;
+      case 2: in.insert(in.begin() + at, (uint8_t)next()); break;
+      case 3: if (!in.empty()) in.erase(in.begin() + at); break;
+      case 4: in.resize(at); break;
+      case 5: in.insert(in.end(), in.begin() + at, in.end()); break;   // repeat the tail
+    }
+  }
+  if (in.size() > MAX_INPUT_BYTES) in.resize(MAX_INPUT_BYTES);
+  return in;
+}
+
+
+int main(int argc, char **argv)
+{
+  long runs = 0;
+  std::string firstDir;
+  for (int i = 1; i < argc; i++)
+  {
+    if (strncmp(argv[i], "-runs=", 6) == 0) runs = atol(argv[i] + 6);
+    else if (strncmp(argv[i], "-worst=", 7) == 0) nbrWorst = atol(argv[i] + 7);
+    else if (argv[i][0] != '-')
+    {
+      if (firstDir.empty()) firstDir = argv[i];
+      load(argv[i]);
+    }
+  }
+  size_t nbrLoaded = corpus.size();
+  for (size_t i = 0; i < nbrLoaded; i++) run(corpus[i]);
+  if (corpus.empty()) corpus.push_back(Input());
+  for (long r = 0; r < runs; r++) run(mutate(corpus[next() % corpus.size()]));
+  remove("crash-input");
+  printf("%s: %zu inputs, %ld mutations ok\r\n", argv[0], nbrLoaded, runs);
+  if (nbrWorst && !firstDir.empty()) save(firstDir);
+  return 0;
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <stdio.h>
+
+/**
+ * Checks for the host tests. A failed check is printed and the
+ * test ends with checkResult(), which returns the exit status.
+ */
+static int checksFailed = 0;
+
+#define CHECK(cond) do { if (!(cond)) { \
+    printf("%s:%d: CHECK(%s) failed\r\n", __FILE__, __LINE__, #cond); checksFailed++; } } while (0)
+
+#define CHECK_EQ(a, b) do { long long _a = (a), _b = (b); if (_a != _b) { \
+    printf("%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\r\n", __FILE__, __LINE__, #a, #b, _a, _b); checksFailed++; } } while (0)
+
+static int checkResult(const char *name)
+{
+  printf("%s: %s\r\n", name, checksFailed ? "FAILED" : "ok");
+  return checksFailed ? 1 : 0;
+}
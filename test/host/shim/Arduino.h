@@ -0,0 +1,76 @@
+#pragma once
+/**
+ * Just enough of the Arduino core to build the parts of the firmware 
+ * which do not touch the hardware on the host, see ../Makefile
+ */
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <time.h>
+#include <algorithm>
+#include <string>
+
+#define PROGMEM
+#define IRAM_ATTR
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+#define log_e(fmt, ...) fprintf(stderr, "E " fmt "\n", ##__VA_ARGS__)
+#define log_w(fmt, ...) fprintf(stderr, "W " fmt "\n", ##__VA_ARGS__)
+#define log_i(fmt, ...) fprintf(stderr, "I " fmt "\n", ##__VA_ARGS__)
+#define log_d(fmt, ...)
+
+inline size_t strlcpy(char *dst, const char *src, size_t size)
+{
+  size_t len = strlen(src);
+  if (size) { size_t n = std::min(len, size - 1); memcpy(dst, src, n); dst[n] = '\0'; }
+  return len;
+}
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+uint32_t esp_random();
+void randomSeed(uint32_t seed);
+
+// FreeRTOS, tasks are not started and critical sections do nothing
+typedef uint32_t TickType_t;
+typedef void *TaskHandle_t;
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) (void)(mux)
+#define portEXIT_CRITICAL(mux)  (void)(mux)
+#define tskIDLE_PRIORITY 0
+#define pdPASS           1
+#define pdTRUE           1
+#define pdMS_TO_TICKS(ms) (ms)
+#define GPIO_NUM_21      21
+#define GPIO_NUM_22      22
+inline TickType_t xTaskGetTickCount() { return millis(); }
+inline void vTaskDelayUntil(TickType_t *wake, TickType_t ticks) { *wake += ticks; }
+inline void xTaskNotifyGive(TaskHandle_t task) {}
+inline uint32_t ulTaskNotifyTake(int clear, TickType_t ticks) { return 0; }
+inline int xTaskCreatePinnedToCore(void (*fn)(void *), const char *name, uint32_t stack, void *arg, int prio, void *handle, int core) { return pdPASS; }
+
+class Print
+{
+  public:
+    virtual ~Print() {}
+    virtual size_t write(const uint8_t *buf, size_t size) = 0;
+    size_t print(const char *s)   { return write((const uint8_t *)s, strlen(s)); }
+    size_t println(const char *s = "") { return print(s) + print("\r\n"); }
+};
+
+// output goes to stdout, or to capture if it is set
+class HardwareSerial : public Print
+{
+  public:
+    int printf(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+    size_t write(const uint8_t *buf, size_t size) override;
+    std::string *capture = nullptr;
+};
+extern HardwareSerial Serial;
@@ -0,0 +1,43 @@
+#pragma once
+#include <Arduino.h>
+
+/**
+ * Files of the host file system below a root directory, 
+ * reading and writing only
+ */
+#define FILE_READ  "r"
+#define FILE_WRITE "w"
+
+namespace fs
+{
+  enum SeekMode { SeekSet = SEEK_SET, SeekCur = SEEK_CUR, SeekEnd = SEEK_END };
+
+  class File
+  {
+    public:
+      File(FILE *f = nullptr) : _f(f) {}
+      size_t read(uint8_t *buf, size_t size)        { return _f ? fread(buf, 1, size, _f) : 0; }
+      size_t write(const uint8_t *buf, size_t size) { return _f ? fwrite(buf, 1, size, _f) : 0; }
+      bool seek(uint32_t pos, SeekMode mode = SeekSet) { return _f && fseek(_f, pos, mode) == 0; }
+      size_t position() const                       { return _f ? ftell(_f) : 0; }
+      size_t size() const;
+      void close()                                  { if (_f) fclose(_f); _f = nullptr; }
+      operator bool() const                         { return _f != nullptr; }
+
+    private:
+      FILE *_f;
+  };
+
+  class FS
+  {
+    public:
+      FS(const char *root) : _root(root) {}
+      File open(const char *path, const char *mode = FILE_READ);
+      bool exists(const char *path);
+
+    private:
+      const char *_root;
+  };
+}
+
+using namespace fs;
@@ -0,0 +1,4 @@
+#pragma once
+#include <FS.h>
+
+extern fs::FS LittleFS;   // the data folder of the project
@@ -0,0 +1,8 @@
+#pragma once
+#include <Arduino.h>
+
+/**
+ * The network is not available on the host, only the 
+ * type of a client for the declarations of httpPool.h
+ */
+class WiFiClient {};
@@ -0,0 +1,16 @@
+#pragma once
+#include <Arduino.h>
+
+/**
+ * I2C without devices, every address stays unanswered
+ */
+class TwoWire
+{
+  public:
+    bool begin(int sda, int scl, uint32_t frequency) { return true; }
+    void beginTransmission(uint8_t address)          {}
+    uint8_t endTransmission()                        { return 2; }   // address not acknowledged
+    size_t write(uint8_t data)                       { return 1; }
+    size_t write(const uint8_t *data, size_t len)    { return len; }
+};
+extern TwoWire Wire;
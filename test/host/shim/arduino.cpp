@@ -0,0 +1,49 @@
+#include <Arduino.h>
+#include <Wire.h>
+#include <chrono>
+#include <thread>
+
+HardwareSerial Serial;
+TwoWire Wire;
+
+static const auto start = std::chrono::steady_clock::now();
+static uint32_t randomState = 1;
+
+uint32_t micros()
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+uint32_t millis()        { return micros() / 1000; }
+void delay(uint32_t ms)  { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+
+/**
+ * xorshift, the same numbers on every run unless seeded
+ */
+uint32_t esp_random()
+{
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return randomState;
+}
+
+void randomSeed(uint32_t seed) { randomState = seed ? seed : 1; }
+
+int HardwareSerial::printf(const char *fmt, ...)
+{
+  char buf[512];
+  va_list args;
+  va_start(args, fmt);
+  int n = vsnprintf(buf, sizeof(buf), fmt, args);
+  va_end(args);
+  write((const uint8_t *)buf, std::min<size_t>(std::max(n, 0), sizeof(buf) - 1));
+  return n;
+}
+
+size_t HardwareSerial::write(const uint8_t *buf, size_t size)
+{
+  if (capture) capture->append((const char *)buf, size);
+  else         fwrite(buf, 1, size, stdout);
+  return size;
+}
@@ -0,0 +1,33 @@
+#include <FS.h>
+#include <LittleFS.h>
+#include <string>
+
+#ifndef HOST_FS_ROOT
+#define HOST_FS_ROOT "../../data"
+#endif
+
+fs::FS LittleFS(HOST_FS_ROOT);
+
+size_t fs::File::size() const
+{
+  if (!_f) return 0;
+  long pos = ftell(_f);
+  fseek(_f, 0, SEEK_END);
+  long size = ftell(_f);
+  fseek(_f, pos, SEEK_SET);
+  return size;
+}
+
+fs::File fs::FS::open(const char *path, const char *mode)
+{
+  std::string name = std::string(_root) + path;
+  return File(fopen(name.c_str(), *mode == 'w' ? "wb" : "rb"));
+}
+
+bool fs::FS::exists(const char *path)
+{
+  File f = open(path);
+  bool found = f;
+  f.close();
+  return found;
+}
@@ -0,0 +1,135 @@
+#include <Arduino.h>
+#include <string>
+#include <vector>
+#include "display.h"
+#include "check.h"
+
+/**
+ * The display pipeline without an SSD1306: frames are rendered into
+ * the framebuffer and only what changed reaches the virtual display
+ */
+
+static uint16_t peak;
+
+void dspPeaks(uint16_t &left, uint16_t &right)
+{
+  left = right = peak;
+  peak = 0;
+}
+
+
+class Capture : public Print
+{
+  public:
+    size_t write(const uint8_t *buf, size_t size) override { text.append((const char *)buf, size); return size; }
+    std::string text;
+};
+
+
+static std::vector<std::string> split(const std::string &text)
+{
+  std::vector<std::string> out;
+  for (size_t pos = 0, end; (end = text.find("\r\n", pos)) != std::string::npos; pos = end + 2)
+    out.push_back(text.substr(pos, end - pos));
+  return out;
+}
+
+
+static std::vector<std::string> lines(VirtualDisplay &d)
+{
+  Capture c;
+  d.print(c);
+  return split(c.text);
+}
+
+
+static bool blank(const std::string &line, size_t from, size_t to)
+{
+  return line.find_first_not_of(' ', from) >= to;
+}
+
+
+static void testVirtualDisplay()
+{
+  VirtualDisplay d;
+  uint8_t data[] = { 0x01, 0x02, 0x03, 0xFF };
+  d.write(1, 10, 13, data);
+  CHECK_EQ(d.writes, 1);
+  CHECK_EQ(d.bytes, 4);
+
+  std::vector<std::string> l = lines(d);
+  CHECK_EQ(l.size(), DISPLAY_PAGES * 4);
+  for (auto &line : l) CHECK_EQ(line.size(), DISPLAY_WIDTH);
+  // page 1 starts at row 8, character line 4 holds rows 8 and 9
+  CHECK(l[4].substr(10, 4) == "\".88");
+  CHECK(l[5].substr(10, 4) == "   8");
+  CHECK(blank(l[3], 0, DISPLAY_WIDTH) && blank(l[4], 14, DISPLAY_WIDTH));
+}
+
+
+static void testFrames()
+{
+  initDisplay();
+  displayStation("SRF 3");
+  displayTitle("ABCDEFGHIJKLMNOPQRSTUVWXYZabcd");
+  displayVolume(0, 10);
+
+  // the first frame sends the pages in use, pages 1 and 4 stay empty
+  CHECK_EQ(displayFrame(), 6 * DISPLAY_WIDTH);
+  CHECK_EQ(displayFrame(), 0);
+
+  // one digit of the volume changes
+  displayVolume(0, 11);
+  CHECK_EQ(displayFrame(), 5);
+
+  // a full scale peak, then the meters fall back by 4 columns
+  peak = 0x7FFF;
+  CHECK_EQ(displayFrame(), 2 * 120);
+  CHECK_EQ(displayFrame(), 2 * 4);
+  for (int i = 0; i < 120 / 4 - 1; i++) displayFrame();
+  CHECK_EQ(displayFrame(), 0);
+}
+
+
+/**
+ * The lines printed by showDisplay(): a blank line, the 
+ * pixels and the count of updates
+ */
+static std::vector<std::string> shown()
+{
+  std::string text;
+  Serial.capture = &text;
+  showDisplay("");
+  Serial.capture = nullptr;
+  return split(text);
+}
+
+
+static void testText()
+{
+  // pages 2 and 3 are character lines 8 to 15, after the blank line
+  std::vector<std::string> l = shown();
+  CHECK_EQ(l.size(), 1 + DISPLAY_PAGES * 4 + 1);
+  CHECK(l.back().find("updates") != std::string::npos);
+  CHECK(!blank(l[1 + 8], 0, 6 * 21) && blank(l[1 + 8], 6 * 21, DISPLAY_WIDTH));   // 21 characters
+  CHECK(!blank(l[1 + 12], 0, 6 * 9) && blank(l[1 + 12], 6 * 9, DISPLAY_WIDTH));   // the 9 which wrap
+
+  // a UTF-8 character is shown as one '?'
+  displayStation("Z?rich");
+  displayFrame();
+  std::vector<std::string> expected = shown();
+  displayStation("Z\xC3\xBCrich");
+  CHECK_EQ(displayFrame(), 0);
+  l = shown();
+  CHECK(std::equal(l.begin(), l.end() - 1, expected.begin()));
+  CHECK(!blank(l[1], 0, 6 * 6) && blank(l[1], 6 * 6, DISPLAY_WIDTH));
+}
+
+
+int main()
+{
+  testVirtualDisplay();
+  testFrames();
+  testText();
+  return checkResult("test_display");
+}
@@ -0,0 +1,86 @@
+#include <Arduino.h>
+#include "dns.h"
+#include "check.h"
+
+/**
+ * Responses as a DNS server sends them, for the query of the 
+ * A records of stream.srg-ssr.ch with id 0x1234
+ */
+static const uint8_t query[] =
+{
+  0x12, 0x34, 0x01, 0x00, 0, 1, 0, 0, 0, 0, 0, 0,
+  6, 's', 't', 'r', 'e', 'a', 'm', 7, 's', 'r', 'g', '-', 's', 's', 'r', 2, 'c', 'h', 0,
+  0, 1, 0, 1
+};
+
+// a CNAME whose name is a label followed by a pointer, then two A records
+static const uint8_t cnameAnswer[] =
+{
+  0x12, 0x34, 0x81, 0x80, 0, 1, 0, 3, 0, 0, 0, 0,
+  6, 's', 't', 'r', 'e', 'a', 'm', 7, 's', 'r', 'g', '-', 's', 's', 'r', 2, 'c', 'h', 0,
+  0, 1, 0, 1,
+  0xC0, 12, 0, 5, 0, 1, 0, 0, 0, 60, 0, 6, 3, 'c', 'd', 'n', 0xC0, 19,       // stream.srg-ssr.ch CNAME cdn.srg-ssr.ch
+  3, 'c', 'd', 'n', 0xC0, 19, 0, 1, 0, 1, 0, 0, 0, 60, 0, 4, 10, 0, 0, 1,    // cdn + pointer, A 10.0.0.1
+  0xC0, 47, 0, 1, 0, 1, 0, 0, 0, 60, 0, 4, 10, 0, 0, 2                        // pointer, A 10.0.0.2
+};
+
+
+static uint32_t ip(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+{
+  const uint8_t bytes[] = { a, b, c, d };
+  uint32_t v;
+  memcpy(&v, bytes, 4);
+  return v;
+}
+
+
+static void testQuery()
+{
+  uint8_t msg[DNS_MSG_SIZE];
+  CHECK_EQ(dnsBuildQuery("stream.srg-ssr.ch", 0x1234, msg, sizeof(msg)), sizeof(query));
+  CHECK(memcmp(msg, query, sizeof(query)) == 0);
+  CHECK_EQ(dnsBuildQuery("a..b", 1, msg, sizeof(msg)), 0);
+  CHECK_EQ(dnsBuildQuery("stream.srg-ssr.ch", 1, msg, 20), 0);
+}
+
+
+static void testAnswer()
+{
+  uint32_t addrs[4];
+  CHECK_EQ(dnsParseAnswer(cnameAnswer, sizeof(cnameAnswer), 0x1234, addrs, 4), 2);
+  CHECK(addrs[0] == ip(10, 0, 0, 1));
+  CHECK(addrs[1] == ip(10, 0, 0, 2));
+  CHECK_EQ(dnsParseAnswer(cnameAnswer, sizeof(cnameAnswer), 0x1234, addrs, 1), 1);
+
+  // another id, a query and an error are no answer to the query
+  CHECK_EQ(dnsParseAnswer(cnameAnswer, sizeof(cnameAnswer), 0x4321, addrs, 4), -1);
+  CHECK_EQ(dnsParseAnswer(query, sizeof(query), 0x1234, addrs, 4), -1);
+  uint8_t msg[sizeof(cnameAnswer)];
+  memcpy(msg, cnameAnswer, sizeof(msg));
+  msg[3] = 0x83;   // NXDOMAIN
+  CHECK_EQ(dnsParseAnswer(msg, sizeof(msg), 0x1234, addrs, 4), 0);
+}
+
+
+static void testTruncated()
+{
+  // every prefix of the answer is parsed without reading past it
+  uint32_t addrs[4];
+  for (size_t len = 0; len < sizeof(cnameAnswer); len++)
+  {
+    uint8_t *msg = (uint8_t *)malloc(len + 1);
+    memcpy(msg, cnameAnswer, len);
+    int n = dnsParseAnswer(msg, len, 0x1234, addrs, 4);
+    CHECK(n <= (len == sizeof(cnameAnswer) ? 2 : 1));
+    free(msg);
+  }
+}
+
+
+int main()
+{
+  testQuery();
+  testAnswer();
+  testTruncated();
+  return checkResult("test_dns");
+}
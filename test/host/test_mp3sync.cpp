@@ -0,0 +1,43 @@
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <vector>
+#include "mp3Sync.h"
+#include "check.h"
+
+/**
+ * Bursts of random bytes in the stereotest file, the chain of headers 
+ * must lock onto the next true frame every time
+ */
+#define TRIALS 500
+#define BURST  64
+
+int main()
+{
+  File f = LittleFS.open("/stereotest440-445.mp3", FILE_READ);
+  std::vector<uint8_t> orig(f.size());
+  CHECK(f.read(orig.data(), orig.size()) == orig.size());
+  f.close();
+
+  std::vector<bool> isFrame(orig.size());
+  Mp3Header h;
+  for (int32_t pos = mp3FindSync(orig.data(), orig.size()); pos >= 0 && pos + 4u <= orig.size() && parseMp3Header(&orig[pos], h); pos += h.frameLen)
+    isFrame[pos] = true;
+  CHECK(isFrame[0]);
+
+  int falseLocks = 0, naiveFalseLocks = 0;
+  for (int t = 0; t < TRIALS; t++)
+  {
+    std::vector<uint8_t> buf = orig;
+    size_t at = 1024 + esp_random() % (buf.size() - 8192);
+    for (int i = 0; i < BURST; i++) buf[at + i] = esp_random();
+
+    int32_t k = mp3FindSync(&buf[at], buf.size() - at);
+    if (k < 0 || !isFrame[at + k]) falseLocks++;
+    size_t n = 0;
+    while (at + n + 4 <= buf.size() && !parseMp3Header(&buf[at + n], h)) n++;
+    if (!isFrame[at + n]) naiveFalseLocks++;
+  }
+  CHECK_EQ(falseLocks, 0);
+  CHECK(naiveFalseLocks > 0);   // the burst does hide false syncwords
+  return checkResult("test_mp3sync");
+}
@@ -0,0 +1,110 @@
+#include <Arduino.h>
+#include <vector>
+#include "scheduler.h"
+#include "clock.h"
+#include "check.h"
+#include "jobs.h"
+
+/**
+ * The timer wheel on the virtual clock: the test runs the due jobs 
+ * and moves the time on to the next expiry, as the scheduler task 
+ * sleeps until then on the board
+ */
+typedef std::vector<uint32_t> Runs;
+
+static void record(void *ctx) { ((Runs *)ctx)->push_back(clockMs()); }
+
+
+static void runFor(uint32_t ms)
+{
+  uint32_t msEnd = clockMs() + ms;
+  while (true)
+  {
+    uint32_t wait = runDueJobs();
+    if (clockMs() == msEnd) break;
+    clockAdvance(std::min(wait, msEnd - clockMs()));
+  }
+}
+
+
+static bool periodic(const Runs &runs, uint32_t msFirst, uint32_t msPeriod)
+{
+  for (size_t i = 0; i < runs.size(); i++) if (runs[i] != msFirst + i * msPeriod) return false;
+  return true;
+}
+
+
+static void testTimers()
+{
+  static Runs fast, slow, hourly, once, late;
+  uint32_t ms0 = clockMs();
+  CHECK(addTimer("fast",    50,      50,      JOB_HIGH,   record, &fast) >= 0);
+  CHECK(addTimer("slow",    5000,    30000,   JOB_NORMAL, record, &slow) >= 0);    // level 1
+  CHECK(addTimer("hourly",  3600000, 3600000, JOB_LOW,    record, &hourly) >= 0);  // level 2
+  CHECK(addTimer("once",    7000,    0,       JOB_LOW,    record, &once) >= 0);
+  CHECK(addTimer("5 hours", 18000000, 0,      JOB_LOW,    record, &late) >= 0);    // beyond the wheel
+
+  runFor(6 * 3600000);
+
+  CHECK_EQ(fast.size(), 6 * 3600000 / 50);
+  CHECK(periodic(fast, ms0 + 50, 50));
+  CHECK_EQ(slow.size(), (6 * 3600000 - 5000) / 30000 + 1);
+  CHECK(periodic(slow, ms0 + 5000, 30000));
+  CHECK_EQ(hourly.size(), 6);
+  CHECK(periodic(hourly, ms0 + 3600000, 3600000));
+  CHECK_EQ(once.size(), 1);
+  CHECK(periodic(once, ms0 + 7000, 0));
+  CHECK_EQ(late.size(), 1);
+  CHECK(periodic(late, ms0 + 18000000, 0));
+}
+
+
+/**
+ * startJobs() of the firmware for ten hours, its jobs record when they 
+ * run: the stream becomes stable after two hours, then the pre-render 
+ * check must stop re-arming
+ */
+
+static uint32_t msStable;
+static Runs menu, prebuffer, prerender, pool;
+
+void showMenu(const char*)  { menu.push_back(clockMs()); }
+void prebufferPoll()        { prebuffer.push_back(clockMs()); }
+void httpPoolMaintain()     { pool.push_back(clockMs()); }
+
+bool ttsPrerenderPoll()
+{
+  prerender.push_back(clockMs());
+  return clockMs() >= msStable;
+}
+
+
+static void testStartJobs()
+{
+  uint32_t ms0 = clockMs();
+  msStable = ms0 + 2 * 3600000;
+  startJobs();
+
+  runFor(10 * 3600000);
+
+  CHECK_EQ(menu.size(), 1);
+  CHECK(periodic(menu, ms0 + 5000, 0));
+  CHECK_EQ(prebuffer.size(), 10 * 3600000 / 50);
+  CHECK(periodic(prebuffer, ms0 + 50, 50));
+  CHECK_EQ(pool.size(), 10 * 3600);
+  CHECK(periodic(pool, ms0 + 1000, 1000));
+  CHECK_EQ(prerender.size(), (2 * 3600000 - 5000) / 500 + 1);
+  CHECK(periodic(prerender, ms0 + 5000, 500));
+  CHECK_EQ(prerender.back(), msStable);
+
+  // the re-arming left the slots free
+  for (int i = 0; i < 8; i++) CHECK(addTimer("free slot", 1000, 0, JOB_LOW, record, &menu) >= 0);
+}
+
+
+int main()
+{
+  testTimers();
+  testStartJobs();
+  return checkResult("test_scheduler");
+}
@@ -0,0 +1,285 @@
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <string>
+#include <vector>
+#include "splicer.h"
+#include "mp3Sync.h"
+#include "check.h"
+
+/**
+ * A live station is played over two simulated paths. Frame i of the
+ * station is sent at i * FRAME_MS, a path delivers it LATENCY ms later
+ * in chunks of random size, unless it stalls. The decoder starts after
+ * PREBUFFER_MS and takes a frame every FRAME_MS.
+ */
+#define FRAME_MS      26
+#define PREBUFFER_MS  800
+#define LOOPS         12     // the fixture is short, the station repeats it
+
+typedef std::vector<uint8_t> Bytes;
+struct Frame { size_t pos, len; };
+
+struct Path
+{
+  Bytes bytes;
+  std::vector<Frame> frames;
+  uint32_t latency = 0;
+  uint32_t stallFrom = 0, stallTo = 0;   // no bytes in between, then the backlog
+  std::vector<size_t> damaged;           // frames whose header is overwritten
+  size_t sent = 0;
+};
+
+static std::vector<Bytes> station;
+static size_t nbrFrames;   // the last frame of the station is never complete, no header follows
+
+
+/**
+ * The frames of the fixture, repeated LOOPS times with the last byte
+ * of each repetition changed, so that no two frames are equal
+ */
+static void loadStation()
+{
+  File f = LittleFS.open("/stereotest440-445.mp3", FILE_READ);
+  Bytes file(f.size());
+  f.read(file.data(), file.size());
+  f.close();
+
+  int32_t pos = mp3FindSync(file.data(), file.size());
+  Mp3Header h;
+  std::vector<Bytes> fixture;
+  while (pos >= 0 && pos + 4u <= file.size() && parseMp3Header(&file[pos], h) && (size_t)pos + h.frameLen <= file.size())
+  {
+    fixture.emplace_back(file.begin() + pos, file.begin() + pos + h.frameLen);
+    pos += h.frameLen;
+  }
+  for (uint8_t loop = 0; loop < LOOPS; loop++)
+  {
+    for (Bytes fr : fixture)
+    {
+      fr.back() ^= loop;
+      station.push_back(fr);
+    }
+  }
+  nbrFrames = station.size() - 1;
+}
+
+
+static Path makePath(uint32_t latency, uint8_t variant = 0)
+{
+  Path p;
+  p.latency = latency;
+  for (Bytes fr : station)
+  {
+    fr[10] ^= variant;   // another encoder: the same headers, other bytes
+    p.frames.push_back({ p.bytes.size(), fr.size() });
+    p.bytes.insert(p.bytes.end(), fr.begin(), fr.end());
+  }
+  return p;
+}
+
+
+static void damage(Path &p, size_t frame, size_t len)
+{
+  for (size_t i = 0; i < len; i++) p.bytes[p.frames[frame].pos + i] = esp_random();
+  p.damaged.push_back(frame);
+}
+
+
+static void deliver(Path &p, MirrorQueue &q, uint32_t ms)
+{
+  if (ms >= p.stallFrom && ms < p.stallTo) return;
+  if (ms < p.latency) return;
+  size_t live = std::min<size_t>((ms - p.latency) / FRAME_MS + 1, p.frames.size());
+  size_t avail = live == p.frames.size() ? p.bytes.size() : p.frames[live].pos;
+  while (p.sent < avail && q.space() > 0)
+  {
+    size_t n = std::min<size_t>({ 1 + esp_random() % 700, avail - p.sent, q.space() });
+    q.append(&p.bytes[p.sent], n);
+    p.sent += n;
+  }
+}
+
+
+struct Result { std::vector<Bytes> out; uint32_t lateMs = 0; };
+
+static Result run(Path &a, Path &b, Splicer &splicer, MirrorQueue *queue)
+{
+  Result r;
+  uint8_t frame[FRAME_MAX_LEN];
+  uint32_t msDue = PREBUFFER_MS;
+  uint32_t msEnd = station.size() * FRAME_MS + 2000;
+  for (uint32_t ms = 0; ms < msEnd; ms++)
+  {
+    deliver(a, queue[0], ms);
+    deliver(b, queue[1], ms);
+    if (ms < msDue) continue;
+    size_t len = splicer.next(frame, ms);
+    if (len == 0)
+    {
+      if (ms < station.size() * FRAME_MS) r.lateMs++;   // not at the end of the station
+      continue;
+    }
+    r.out.emplace_back(frame, frame + len);
+    msDue += FRAME_MS;
+  }
+  return r;
+}
+
+
+static size_t firstDifference(const std::vector<Bytes> &out, const std::vector<Bytes> &expected)
+{
+  size_t i = 0;
+  while (i < out.size() && i < expected.size() && out[i] == expected[i]) i++;
+  return i;
+}
+
+
+static uint8_t ring[MIRRORS][16384];
+
+static void testStall()
+{
+  MirrorQueue q[MIRRORS] = { { ring[0], sizeof(ring[0]) }, { ring[1], sizeof(ring[1]) } };
+  Splicer splicer(q[0], q[1]);
+  Path a = makePath(0), b = makePath(300);
+  a.stallFrom = 2000; a.stallTo = 5000;
+  Result r = run(a, b, splicer, q);
+
+  CHECK_EQ(r.out.size(), nbrFrames);
+  CHECK_EQ(firstDifference(r.out, station), nbrFrames);
+  CHECK_EQ(r.lateMs, 0);
+  CHECK_EQ(splicer.jumps, 0);
+  CHECK(splicer.switches >= 1);
+  CHECK(splicer.frames[1] > 0);
+}
+
+
+static void testDamage()
+{
+  MirrorQueue q[MIRRORS] = { { ring[0], sizeof(ring[0]) }, { ring[1], sizeof(ring[1]) } };
+  Splicer splicer(q[0], q[1]);
+  Path a = makePath(0), b = makePath(150);
+  for (size_t k = 50; k + 100 < nbrFrames; k += 200)
+  {
+    damage(a, k, 300);
+    damage(b, k + 100, 300);
+  }
+  Result r = run(a, b, splicer, q);
+
+  CHECK_EQ(firstDifference(r.out, station), nbrFrames);
+  CHECK_EQ(r.lateMs, 0);
+  CHECK_EQ(splicer.jumps, 0);
+  CHECK(q[0].resyncs >= a.damaged.size());
+  CHECK(q[1].resyncs >= b.damaged.size());
+}
+
+
+static void testOneDamagedPath()
+{
+  MirrorQueue q[MIRRORS] = { { ring[0], sizeof(ring[0]) }, { ring[1], sizeof(ring[1]) } };
+  Splicer splicer(q[0], q[1]);
+  Path a = makePath(0), b = makePath(0);
+  b.stallFrom = 0; b.stallTo = UINT32_MAX;
+  damage(a, 100, 4);
+  Result r = run(a, b, splicer, q);
+
+  // the frame before the damage and the damaged one are lost, without a pause
+  CHECK_EQ(r.out.size(), nbrFrames - 2);
+  CHECK_EQ(firstDifference(r.out, station), 99);
+  CHECK(r.out[99] == station[101]);
+  CHECK_EQ(r.lateMs, 0);
+  CHECK_EQ(splicer.jumps, 1);
+}
+
+
+static void testOtherContent()
+{
+  MirrorQueue q[MIRRORS] = { { ring[0], sizeof(ring[0]) }, { ring[1], sizeof(ring[1]) } };
+  Splicer splicer(q[0], q[1]);
+  Path a = makePath(0), b = makePath(0, 0x55);
+  a.stallFrom = 3000; a.stallTo = UINT32_MAX;
+  Result r = run(a, b, splicer, q);
+
+  // b never matches, after a is gone it continues with a single jump
+  CHECK_EQ(splicer.jumps, 1);
+  CHECK_EQ(splicer.switches, 1);
+  CHECK(r.lateMs >= SPLICE_WAIT_MS && r.lateMs < SPLICE_WAIT_MS + 2 * FRAME_MS);
+  size_t n = firstDifference(r.out, station);
+  CHECK(n > 0 && n < nbrFrames);
+  CHECK(r.out.size() > n && r.out[n] != station[n]);
+}
+
+
+static void testSilence()
+{
+  // digital silence, a run of equal frames, must keep its length
+  std::vector<Bytes> saved = station;
+  for (size_t i = 200; i < 300; i++) station[i] = station[200];
+  MirrorQueue q[MIRRORS] = { { ring[0], sizeof(ring[0]) }, { ring[1], sizeof(ring[1]) } };
+  Splicer splicer(q[0], q[1]);
+  Path a = makePath(0), b = makePath(400);
+  a.stallFrom = 200 * FRAME_MS + 500; a.stallTo = 200 * FRAME_MS + 2500;
+  Result r = run(a, b, splicer, q);
+
+  CHECK_EQ(firstDifference(r.out, station), nbrFrames);
+  CHECK_EQ(splicer.jumps, 0);
+  station = saved;
+}
+
+
+/**
+ * Metadata blocks between the audio bytes, received in chunks of 
+ * any size, leave the audio unchanged and report each title once
+ */
+static void testIcy()
+{
+  const uint32_t metaInt = 100;
+  Bytes audio(1000), stream;
+  for (size_t i = 0; i < audio.size(); i++) audio[i] = esp_random();
+  std::vector<std::string> titles = { "", "StreamTitle='Bach - Air';StreamUrl='';", "", "StreamTitle='Bach - Air';", "StreamTitle='Reger';" };
+  for (size_t i = 0; i < audio.size(); i += metaInt)
+  {
+    stream.insert(stream.end(), audio.begin() + i, audio.begin() + i + metaInt);
+    std::string meta = titles[i / metaInt % titles.size()];
+    meta.resize((meta.size() + 15) / 16 * 16, '\0');
+    stream.push_back(meta.size() / 16);
+    stream.insert(stream.end(), meta.begin(), meta.end());
+  }
+
+  IcyStripper icy;
+  icy.begin(metaInt);
+  Bytes out;
+  std::vector<std::string> seen;
+  char title[ICY_TITLE_MAX];
+  for (size_t pos = 0; pos < stream.size(); )
+  {
+    uint8_t chunk[64];
+    size_t n = std::min<size_t>(1 + esp_random() % sizeof(chunk), stream.size() - pos);
+    memcpy(chunk, &stream[pos], n);
+    pos += n;
+    n = icy.strip(chunk, n);
+    out.insert(out.end(), chunk, chunk + n);
+    if (icy.newTitle(title, sizeof(title))) seen.push_back(title);
+  }
+  CHECK(out == audio);
+  CHECK_EQ(seen.size(), 4);   // twice around the titles, the repeated one is not reported again
+  CHECK(seen[0] == "Bach - Air" && seen[1] == "Reger" && seen[2] == "Bach - Air" && seen[3] == "Reger");
+
+  // a response without metadata passes unchanged
+  icy.begin(0);
+  uint8_t plain[3] = { 1, 2, 3 };
+  CHECK_EQ(icy.strip(plain, 3), 3);
+}
+
+
+int main()
+{
+  loadStation();
+  CHECK(station.size() > 1000);
+  testStall();
+  testDamage();
+  testOneDamagedPath();
+  testOtherContent();
+  testSilence();
+  testIcy();
+  return checkResult("test_splicer");
+}
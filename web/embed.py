@@ -0,0 +1,36 @@
+# Compress web/index.html into include/webPage.h before each build.
+# PlatformIO runs it as extra script, it can also be run on its own.
+import gzip
+import hashlib
+import os
+
+try:
+    Import("env")  # noqa: F821
+    root = env["PROJECT_DIR"]  # noqa: F821
+except NameError:
+    root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+src = os.path.join(root, "web", "index.html")
+dst = os.path.join(root, "include", "webPage.h")
+
+with open(src, "rb") as f:
+    gz = gzip.compress(f.read(), compresslevel=9, mtime=0)
+etag = hashlib.sha1(gz).hexdigest()[:16]
+
+lines = ["// generated by web/embed.py from web/index.html, do not edit",
+         "#pragma once",
+         "#include <Arduino.h>",
+         "",
+         '#define WEB_PAGE_ETAG "\\"%s\\""' % etag,
+         "",
+         "static const uint8_t webPageGz[%d] PROGMEM =" % len(gz),
+         "{"]
+for i in range(0, len(gz), 16):
+    lines.append("  " + ", ".join("0x%02x" % b for b in gz[i:i + 16]) + ",")
+lines += ["};", ""]
+text = "\n".join(lines)
+
+old = open(dst).read() if os.path.exists(dst) else None
+if text != old:
+    with open(dst, "w") as f:
+        f.write(text)
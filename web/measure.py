@@ -0,0 +1,36 @@
+# Measure load time and bytes on the wire of the web UI.
+# Usage: python web/measure.py esp32-radio.local
+import http.client
+import sys
+import time
+
+host = sys.argv[1] if len(sys.argv) > 1 else "esp32-radio.local"
+
+
+def fetch(path, headers={}, method="GET"):
+    conn = http.client.HTTPConnection(host, 80, timeout=10)
+    start = time.perf_counter()
+    conn.request(method, path, headers=headers)
+    resp = conn.getresponse()
+    body = resp.read()
+    ms = (time.perf_counter() - start) * 1000
+    head = sum(len(k) + len(v) + 4 for k, v in resp.getheaders()) + 17
+    conn.close()
+    return resp, body, ms, head + len(body)
+
+
+def report(name, resp, ms, wire):
+    print("  %-28s %3d %8.1f ms %7d bytes" % (name, resp.status, ms, wire))
+
+
+resp, body, ms, wire = fetch("/", {"Accept-Encoding": "gzip"})
+report("page, cold", resp, ms, wire)
+etag = resp.getheader("ETag")
+print("  %-28s %s, %s" % ("", resp.getheader("Content-Encoding"), resp.getheader("Cache-Control")))
+
+resp, body, ms, wire = fetch("/", {"Accept-Encoding": "gzip", "If-None-Match": etag})
+report("page, revalidated", resp, ms, wire)
+
+for path in ("/api/menu", "/api/status"):
+    resp, body, ms, wire = fetch(path)
+    report(path, resp, ms, wire)